@@ -0,0 +1,167 @@
+/* Render loop benchmark: cc -O2 bench.c $(cat compile_flags.txt) -o bench */
+#define BENCHMARK
+#include "main.c"
+#include <sys/resource.h>
+
+struct benchmark
+{
+     unsigned int warmupFrames;
+     unsigned int frames;
+     double seconds;
+     char const * label;
+     char const * outputPath;
+};
+
+void usage (char const * const name)
+{
+     fprintf (stderr, "Usage: %s [--frames N | --seconds S] [--warmup N] [--width W] [--height H] [--images N]\n"
+                      "       [--present-policy power|latency | --present-mode immediate|mailbox|fifo|relaxed] [--frames-in-flight N] [--workers N] [--headless]\n"
+                      "       [--device NAME|UUID] [--capture N] [--capture-format ppm|raw|stream] [--dynamic-rendering 0|1] [--replay 0|1]\n"
+                      "       [--outputs N] [--overlay 0|1] [--label text] [--output path]\n", name);
+     exit (EXIT_FAILURE);
+}
+
+void writeStatistics (FILE * const file, char const * const name, struct statistics const statistics)
+{
+     fprintf (file, ", \"%s_ms\": {\"count\": %u, \"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p99\": %.4f}",
+              name, statistics.count, statistics.minimum, statistics.mean, statistics.median, statistics.percentile99);
+}
+
+void writeResult (FILE * const file, struct benchmark const benchmark, struct devices const devices, unsigned int const numberOfFrames, double const seconds)
+{
+     VkPhysicalDeviceProperties properties;
+     vkGetPhysicalDeviceProperties (devices.card, & properties);
+     struct rusage resourceUsage;
+     getrusage (RUSAGE_SELF, & resourceUsage);
+     struct output const * const pointerToOutput = & devices.outputs [0];
+     fprintf (file, "{\"label\": \"%s\", \"device\": \"%s\", \"driver\": %u, \"width\": %d, \"height\": %d, \"headless\": %s, \"outputs\": %u, \"images\": %u, \"present_policy\": \"%s\", \"present_mode\": \"%s\", \"frames_in_flight\": %u",
+              benchmark.label, properties.deviceName, properties.driverVersion, pointerToOutput->size.x, pointerToOutput->size.y, pointerToOutput->chain == VK_NULL_HANDLE ? "true" : "false", devices.numberOfOutputs,
+              pointerToOutput->pointerToImages->count, presentPolicyNames [devices.presentPolicy], pointerToOutput->chain == VK_NULL_HANDLE ? "none" : getPresentModeName (pointerToOutput->presentMode), devices.pointerToFrames->count);
+     fprintf (file, ", \"startup_ms\": %.2f, \"pipeline_cache_bytes\": %zu", devices.startupTime, devices.pointerToPipelines->loadedSize);
+     fprintf (file, ", \"warmup\": %u, \"frames\": %u, \"seconds\": %.4f, \"fps\": %.2f", benchmark.warmupFrames, numberOfFrames, seconds, numberOfFrames / seconds);
+     writeStatistics (file, "frame", getStatistics (devices.pointerToTimings, PHASE_FRAME, numberOfFrames));
+     writeStatistics (file, "gpu", getStatistics (devices.pointerToTimings, PHASE_GPU, numberOfFrames));
+     writeStatistics (file, "record", getStatistics (devices.pointerToTimings, PHASE_RECORD, numberOfFrames));
+     unsigned int const numberOfWorkers = devices.pointerToWorkers ? devices.pointerToWorkers->count : 0;
+     fprintf (file, ", \"workers\": %u, \"worker_record_ms\": [", numberOfWorkers);
+     for (unsigned int i = 0; i < numberOfWorkers; ++i)
+     {
+          struct worker const * const pointerToWorker = & devices.pointerToWorkers->workers [i];
+          fprintf (file, "%s%.4f", i ? ", " : "", pointerToWorker->numberOfRecordings ? 1e3 * pointerToWorker->recordingTime / pointerToWorker->numberOfRecordings : 0);
+     }
+     fprintf (file, "]");
+     struct memoryStatistics const memory = getMemoryStatistics (devices.pointerToAllocator);
+     fprintf (file, ", \"memory\": {\"blocks\": %u, \"allocations\": %u, \"reserved_kib\": %llu, \"used_kib\": %llu, \"requested_kib\": %llu, \"fragmentation\": %.4f}",
+              memory.numberOfBlocks, memory.numberOfAllocations, (unsigned long long) memory.reserved / 1024, (unsigned long long) memory.used / 1024, (unsigned long long) memory.requested / 1024, memory.fragmentation);
+     fprintf (file, ", \"staging\": {\"mib\": %.3f, \"mib_per_s\": %.3f, \"stalls\": %u, \"async_transfer\": %s}",
+              devices.pointerToStaging->bytesInTotal / 1048576.0, getStagingBandwidth (devices.pointerToStaging), devices.pointerToStaging->numberOfStalls, devices.pointerToStaging->numberOfTransfers ? "true" : "false");
+     struct graph const * const pointerToGraph = devices.pointerToGraph;
+     unsigned int const numberOfExecutions = pointerToGraph->numberOfExecutions ? pointerToGraph->numberOfExecutions : 1;
+     fprintf (file, ", \"graph\": {\"synchronization2\": %s, \"passes\": %.2f, \"culled\": %.2f, \"barriers\": %.2f, \"batches\": %.2f}", pointerToGraph->cmdPipelineBarrier2 ? "true" : "false",
+              (double) pointerToGraph->passesInTotal / numberOfExecutions, (double) pointerToGraph->culledInTotal / numberOfExecutions,
+              (double) pointerToGraph->barriersInTotal / numberOfExecutions, (double) pointerToGraph->batchesInTotal / numberOfExecutions);
+     fprintf (file, ", \"rendering\": \"%s\", \"overlay\": %s", devices.renderPass == VK_NULL_HANDLE ? "dynamic" : "render_pass", devices.pointerToOverlay ? "true" : "false");
+     if (pointerToOutput->pointerToReplay)
+     {
+          unsigned int numberOfRecordings = 0, numberOfBuffers = 0;
+          double recordingTime = 0;
+          for (unsigned int i = 0; i < devices.numberOfOutputs; ++i)
+          {
+               numberOfRecordings += devices.outputs [i].pointerToReplay->numberOfRecordings;
+               numberOfBuffers += devices.outputs [i].pointerToReplay->numberOfBuffers;
+               recordingTime += devices.outputs [i].pointerToReplay->recordingTime;
+          }
+          fprintf (file, ", \"replay\": {\"recordings\": %u, \"buffers\": %u, \"record_ms\": %.4f}", numberOfRecordings, numberOfBuffers, numberOfRecordings ? 1e3 * recordingTime / numberOfRecordings : 0);
+     }
+     if (devices.pointerToCapture)
+     {
+          struct capture * const pointerToCapture = devices.pointerToCapture;
+          pthread_mutex_lock (& pointerToCapture->mutex);
+          fprintf (file, ", \"capture\": {\"format\": \"%s\", \"captured\": %u, \"written\": %u, \"dropped\": %u, \"write_ms\": %.4f}", captureFormatNames [pointerToCapture->captureFormat],
+                   pointerToCapture->numberOfCaptures, pointerToCapture->numberOfWrites, pointerToCapture->numberOfDrops, pointerToCapture->numberOfWrites ? 1e3 * pointerToCapture->writeTime / pointerToCapture->numberOfWrites : 0);
+          pthread_mutex_unlock (& pointerToCapture->mutex);
+     }
+     fprintf (file, ", \"peak_rss_kib\": %ld}\n", resourceUsage.ru_maxrss);
+}
+
+VkBool32 isRunning (struct devices const devices)
+{
+     return ! isInterrupted && ! isWindowClosing (devices.numberOfOutputs, devices.outputs);
+}
+
+int main (int const argc, char * const * const argv)
+{
+     struct options options = getOptions ( );
+     options.summaryInterval = 0;
+     if (options.pacing == PACING_IDLE) options.pacing = PACING_UNLIMITED;
+     struct benchmark benchmark = {.warmupFrames = 60, .frames = 600, .seconds = 0, .label = "", .outputPath = "bench_output.txt"};
+     VkBool32 isFrameCountGiven = VK_FALSE;
+     for (int i = 1; i < argc; ++i)
+     {
+          if (! strcmp (argv [i], "--headless"))
+          {
+               options.isHeadless = VK_TRUE;
+               continue;
+          }
+          if (i + 1 == argc) usage (argv [0]);
+          char const * const value = argv [++i];
+          if (! strcmp (argv [i - 1], "--frames"))
+          {
+               benchmark.frames = strtoul (value, NULL, 10);
+               isFrameCountGiven = VK_TRUE;
+          }
+          else if (! strcmp (argv [i - 1], "--seconds")) benchmark.seconds = strtod (value, NULL);
+          else if (! strcmp (argv [i - 1], "--warmup")) benchmark.warmupFrames = strtoul (value, NULL, 10);
+          else if (! strcmp (argv [i - 1], "--width")) options.size.x = strtoul (value, NULL, 10);
+          else if (! strcmp (argv [i - 1], "--height")) options.size.y = strtoul (value, NULL, 10);
+          else if (! strcmp (argv [i - 1], "--images")) options.imageCount = strtoul (value, NULL, 10);
+          else if (! strcmp (argv [i - 1], "--present-mode"))
+          {
+               options.presentMode = getPresentModeByName (value);
+               options.presentPolicy = PRESENT_EXPLICIT;
+          }
+          else if (! strcmp (argv [i - 1], "--present-policy")) options.presentPolicy = getPresentPolicyByName (value);
+          else if (! strcmp (argv [i - 1], "--frames-in-flight")) options.framesInFlight = strtoul (value, NULL, 10);
+          else if (! strcmp (argv [i - 1], "--workers")) options.numberOfWorkers = strtoul (value, NULL, 10);
+          else if (! strcmp (argv [i - 1], "--device")) options.deviceName = value;
+          else if (! strcmp (argv [i - 1], "--capture")) options.captureInterval = strtoul (value, NULL, 10);
+          else if (! strcmp (argv [i - 1], "--capture-format")) options.captureFormat = getCaptureFormatByName (value);
+          else if (! strcmp (argv [i - 1], "--dynamic-rendering")) options.isDynamicRenderingEnabled = strtoul (value, NULL, 10) != 0;
+          else if (! strcmp (argv [i - 1], "--replay")) options.isReplayEnabled = strtoul (value, NULL, 10) != 0;
+          else if (! strcmp (argv [i - 1], "--outputs")) options.numberOfOutputs = strtoul (value, NULL, 10);
+          else if (! strcmp (argv [i - 1], "--overlay")) options.isOverlayEnabled = strtoul (value, NULL, 10) != 0;
+          else if (! strcmp (argv [i - 1], "--label")) benchmark.label = value;
+          else if (! strcmp (argv [i - 1], "--output")) benchmark.outputPath = value;
+          else usage (argv [0]);
+     }
+     if (benchmark.seconds > 0 && ! isFrameCountGiven) benchmark.frames = 0;
+     if (benchmark.frames == 0 && benchmark.seconds <= 0) usage (argv [0]);
+
+     struct devices devices = enter (options);
+     signal (SIGINT, interrupt);
+     for (unsigned int frame = 0; frame < benchmark.warmupFrames && isRunning (devices); ++frame) mainLoop (& devices);
+     try (vkDeviceWaitIdle (devices.logic), "waiting for the warmup to finish");
+     unsigned int const firstFrame = devices.pointerToTimings->count;
+     double const start = getTime ( );
+     while (isRunning (devices))
+     {
+          mainLoop (& devices);
+          if (benchmark.frames && devices.pointerToTimings->count - firstFrame >= benchmark.frames) break;
+          if (benchmark.seconds > 0 && getTime ( ) - start >= benchmark.seconds) break;
+     }
+     try (vkDeviceWaitIdle (devices.logic), "waiting for the measured frames to finish");
+     double const seconds = getTime ( ) - start;
+     for (unsigned int slot = 0; slot < devices.pointerToFrames->count; ++slot) readTimestamps (devices.pointerToTimings, devices.logic, slot);
+     unsigned int const numberOfFrames = devices.pointerToTimings->count - firstFrame;
+
+     FILE * const file = fopen (benchmark.outputPath, "a");
+     if (! file)
+     {
+          perror (benchmark.outputPath);
+          exit (EXIT_FAILURE);
+     }
+     writeResult (file, benchmark, devices, numberOfFrames, seconds);
+     fclose (file);
+     writeResult (stdout, benchmark, devices, numberOfFrames, seconds);
+     return leave (devices);
+}
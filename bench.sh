@@ -0,0 +1,49 @@
+#!/bin/sh
+# Builds the render loop benchmark and sweeps resolution, swapchain image
+# count and present mode, then the headless variants: recording workers,
+# render pass, replay and outputs. Each run appends one JSON line to
+# bench_output.txt. Falls back to xvfb-run and lavapipe when available.
+set -e
+cd "$(dirname "$0")"
+cc -O2 bench.c $(cat compile_flags.txt) -lm -o bench
+
+if [ -z "$VK_ICD_FILENAMES" ]
+then
+     for icd in /usr/share/vulkan/icd.d/lvp_icd.*.json
+     do
+          if [ -e "$icd" ]
+          then export VK_ICD_FILENAMES="$icd"
+          fi
+     done
+fi
+
+run ()
+{
+     if [ -z "$DISPLAY" ] && command -v xvfb-run > /dev/null
+     then xvfb-run -a -s "-screen 0 1920x1080x24" ./bench "$@"
+     else ./bench "$@"
+     fi
+}
+
+FRAMES=${FRAMES:-600}
+WARMUP=${WARMUP:-60}
+for size in ${SIZES:-640x480 1280x720 1920x1080}
+do
+     for images in ${IMAGE_COUNTS:-2 3 4}
+     do
+          for mode in ${PRESENT_MODES:-fifo mailbox immediate}
+          do
+               run --frames "$FRAMES" --warmup "$WARMUP" --width "${size%x*}" --height "${size#*x}" --images "$images" --present-mode "$mode" --label "$size-$images-$mode"
+          done
+     done
+     for workers in ${WORKER_COUNTS:-0 1 2 4}
+     do
+          run --headless --frames "$FRAMES" --warmup "$WARMUP" --width "${size%x*}" --height "${size#*x}" --workers "$workers" --label "$size-headless-$workers"
+     done
+     run --headless --frames "$FRAMES" --warmup "$WARMUP" --width "${size%x*}" --height "${size#*x}" --workers 0 --dynamic-rendering 0 --label "$size-headless-render-pass"
+     run --headless --frames "$FRAMES" --warmup "$WARMUP" --width "${size%x*}" --height "${size#*x}" --replay 1 --label "$size-headless-replay"
+     for outputs in ${OUTPUT_COUNTS:-2 4}
+     do
+          run --headless --frames "$FRAMES" --warmup "$WARMUP" --width "${size%x*}" --height "${size#*x}" --outputs "$outputs" --label "$size-headless-outputs-$outputs"
+     done
+done
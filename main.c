@@ -1,42 +1,686 @@
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <errno.h>
 #include <time.h>
 #include <math.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
 #include <vulkan/vulkan_core.h>
 
+#define LOG_ERROR 0
+#define LOG_WARNING 1
+#define LOG_INFO 2
+#define LOG_DEBUG 3
+#define LOG_TRACE 4
+#ifndef LOG_LEVEL
+#ifdef NDEBUG
+#define LOG_LEVEL LOG_INFO
+#else
+#define LOG_LEVEL LOG_TRACE
+#endif
+#endif
+#define logError(...) logPrint (LOG_ERROR, __VA_ARGS__)
+#define logWarning(...) logPrint (LOG_WARNING, __VA_ARGS__)
+#if LOG_LEVEL >= LOG_INFO
+#define logInfo(...) logPrint (LOG_INFO, __VA_ARGS__)
+#else
+#define logInfo(...) ((void) (0 && printf (__VA_ARGS__)))
+#endif
+#if LOG_LEVEL >= LOG_DEBUG
+#define logDebug(...) logPrint (LOG_DEBUG, __VA_ARGS__)
+#else
+#define logDebug(...) ((void) (0 && printf (__VA_ARGS__)))
+#endif
+#if LOG_LEVEL >= LOG_TRACE
+#define logTrace(...) logPrint (LOG_TRACE, __VA_ARGS__)
+#else
+#define logTrace(...) ((void) (0 && printf (__VA_ARGS__)))
+#endif
+#ifdef NDEBUG
+#define nameObject(logic, type, handle, name) ((void) (logic), (void) (handle))
+#else
+#define nameObject(logic, type, handle, name) setObjectName (logic, type, (uint64_t) (uintptr_t) (handle), name)
+#endif
+#define LOG_RING_SIZE 1024
+#define LOG_MESSAGE_SIZE 512
+#define MEMORY_BLOCK_SIZE (64u << 20)
+#define MEMORY_LEAF_SIZE 256u
+#define STAGING_SIZE (4u << 20)
+#define ARENA_SIZE (256u << 10)
+#define OVERLAY_WIDTH 256u
+#define OVERLAY_HEIGHT 64u
+#define OVERLAY_MARGIN 8u
+#define OVERLAY_BYTES (OVERLAY_WIDTH * OVERLAY_HEIGHT * 4u)
+#define OVERLAY_SCALE (1.0 / 30)
+#define OVERLAY_REFERENCE_HEIGHT 1440u
+#define REPLAY_SWATCH_FORMAT VK_FORMAT_R32G32B32A32_SFLOAT
+#define STARTUP_STEPS 16
+#define IDLE_WAKE_SECONDS 0.25
+#define SPIN_SECONDS 2e-4
+#define STAGING_CONSUMER_STAGES (VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+#define STAGING_CONSUMER_ACCESS (VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT)
+
 struct point {int x; int y;};
+enum pacingMode {PACING_UNLIMITED, PACING_TARGET, PACING_VSYNC, PACING_IDLE};
+enum presentPolicy {PRESENT_POWER_SAVING, PRESENT_LOWEST_LATENCY, PRESENT_EXPLICIT};
+enum validation {VALIDATION_NONE, VALIDATION_STANDARD, VALIDATION_GPU, VALIDATION_SYNCHRONIZATION};
+enum captureFormat {CAPTURE_PPM, CAPTURE_RAW, CAPTURE_STREAM};
+enum readbackState {READBACK_FREE, READBACK_RECORDED, READBACK_QUEUED};
+enum graphAccess {GRAPH_COLOR_ATTACHMENT, GRAPH_SAMPLED, GRAPH_UNIFORM, GRAPH_TRANSFER_SOURCE, GRAPH_TRANSFER_DESTINATION, GRAPH_HOST_READ, GRAPH_PRESENT, NUMBER_OF_GRAPH_ACCESSES};
+struct logSlot
+{
+     atomic_uint sequence;
+     int level;
+     double time;
+     char text [LOG_MESSAGE_SIZE];
+};
+struct logRing
+{
+     struct logSlot slots [LOG_RING_SIZE];
+     atomic_uint head;
+     unsigned int tail;
+     atomic_uint dropped;
+     atomic_int isRunning;
+     pthread_t thread;
+};
+struct pacing
+{
+     enum pacingMode mode;
+     double interval;
+     double deadline;
+     double damageTime;
+     unsigned int numberOfWakeups;
+     unsigned int numberOfRedraws;
+     double latency;
+};
+struct options
+{
+     struct point size;
+     unsigned int framesInFlight;
+     unsigned int numberOfWorkers;
+     unsigned int imageCount;
+     enum presentPolicy presentPolicy;
+     VkPresentModeKHR presentMode;
+     VkBool32 isHeadless;
+     unsigned int frameLimit;
+     enum pacingMode pacing;
+     unsigned int targetRate;
+     unsigned int summaryInterval;
+     char const * timingsPath;
+     enum validation validation;
+     char const * deviceName;
+     VkBool32 isAsyncTransferEnabled;
+     VkBool32 isPipelineCacheEnabled;
+     char const * pipelineCacheDirectory;
+     unsigned int captureInterval;
+     enum captureFormat captureFormat;
+     char const * captureDirectory;
+     unsigned int numberOfCaptureBuffers;
+     VkBool32 isDynamicRenderingEnabled;
+     VkBool32 isReplayEnabled;
+     unsigned int numberOfOutputs;
+     VkBool32 isOverlayEnabled;
+};
+struct memoryBlock
+{
+     VkDeviceMemory memory;
+     unsigned int memoryType;
+     VkDeviceSize size;
+     VkDeviceSize leafSize;
+     unsigned int order;
+     unsigned char * longest;
+     void * pointer;
+     VkDeviceSize used;
+     unsigned int numberOfAllocations;
+};
+struct allocation
+{
+     struct memoryBlock * pointerToBlock;
+     VkDeviceMemory memory;
+     VkDeviceSize offset;
+     VkDeviceSize size;
+     VkDeviceSize requestedSize;
+     void * pointer;
+};
+struct arena
+{
+     VkBuffer buffer;
+     struct allocation allocation;
+     unsigned int numberOfSlots;
+     VkDeviceSize bytesPerSlot;
+     VkDeviceSize * heads;
+     VkDeviceSize peak;
+};
+struct allocator
+{
+     VkPhysicalDevice card;
+     VkDevice logic;
+     VkDeviceSize blockSize;
+     VkDeviceSize leafSize;
+     VkDeviceSize maximumAllocationCount;
+     unsigned int numberOfBlocks;
+     unsigned int capacityOfBlocks;
+     struct memoryBlock ** blocks;
+     VkDeviceSize requested;
+     unsigned int numberOfAllocations;
+     unsigned int allocationsInTotal;
+     unsigned int blocksInTotal;
+};
+struct memoryStatistics
+{
+     unsigned int numberOfBlocks;
+     unsigned int numberOfAllocations;
+     VkDeviceSize reserved;
+     VkDeviceSize used;
+     VkDeviceSize requested;
+     VkDeviceSize largestFree;
+     double fragmentation;
+};
+struct staging
+{
+     VkDevice logic;
+     struct frames * pointerToFrames;
+     struct synchronization * pointerToSynchronization;
+     unsigned int numberOfSlots;
+     VkQueue transferQueue;
+     unsigned int transferQueueFamilyIndex;
+     unsigned int graphicsQueueFamilyIndex;
+     VkCommandPool transferPool;
+     VkCommandBuffer * transferBuffers;
+     VkSemaphore * uploaded;
+     VkBuffer buffer;
+     struct allocation allocation;
+     VkDeviceSize size;
+     uint64_t head;
+     uint64_t tail;
+     uint64_t * ends;
+     unsigned int slot;
+     unsigned int numberOfBufferCopies;
+     unsigned int capacityOfBufferCopies;
+     VkBuffer * bufferDestinations;
+     VkBufferCopy * bufferRegions;
+     VkBufferMemoryBarrier * bufferBarriers;
+     uint64_t bytesInTotal;
+     unsigned int numberOfTransfers;
+     unsigned int numberOfStalls;
+     double stallTime;
+     double origin;
+};
+struct readback
+{
+     VkBuffer buffer;
+     struct allocation allocation;
+     VkDeviceSize capacity;
+     enum readbackState state;
+     unsigned int frame;
+     struct point size;
+     VkImage image;
+};
+struct captureHeader
+{
+     char magic [4];
+     uint32_t frame;
+     uint32_t width;
+     uint32_t height;
+     uint32_t format;
+     uint32_t size;
+};
+struct capture
+{
+     VkDevice logic;
+     struct allocator * pointerToAllocator;
+     VkMemoryPropertyFlags memoryFlags;
+     VkFormat format;
+     enum captureFormat captureFormat;
+     char const * directory;
+     unsigned int interval;
+     unsigned int count;
+     struct readback * readbacks;
+     unsigned int numberOfSlots;
+     unsigned int * pending;
+     unsigned int * queue;
+     unsigned int head;
+     unsigned int tail;
+     pthread_mutex_t mutex;
+     pthread_cond_t queued;
+     int isRunning;
+     pthread_t thread;
+     int streamFile;
+     char * stream;
+     size_t streamSize;
+     size_t streamCapacity;
+     unsigned int numberOfCaptures;
+     unsigned int numberOfWrites;
+     unsigned int numberOfDrops;
+     double writeTime;
+};
+struct overlayCopy
+{
+     struct graph const * pointerToGraph;
+     VkBuffer buffer;
+     VkDeviceSize offset;
+     unsigned int hud;
+     VkImage target;
+     unsigned int scale;
+};
+struct overlay
+{
+     VkFormat format;
+     VkBool32 isSwapped;
+     struct arena * pointerToArena;
+     VkDeviceSize offset;
+     float intervals [OVERLAY_WIDTH];
+     unsigned int numberOfIntervals;
+     double last;
+     struct overlayCopy * copies;
+     unsigned int numberOfUploads;
+};
+struct startup
+{
+     unsigned int count;
+     double origin;
+     double last;
+     char const * names [STARTUP_STEPS];
+     double durations [STARTUP_STEPS];
+};
+struct pipelines
+{
+     VkPhysicalDevice card;
+     VkDevice logic;
+     char path [512];
+     VkPipelineCache cache;
+     size_t loadedSize;
+     double loadTime;
+     pthread_t thread;
+};
 struct images
 {
      unsigned int const count;
      VkImage * const images;
+     struct allocation * const allocations;
      VkImageView * const views;
      VkFramebuffer * const frames;
+     VkSemaphore * const renderFinished;
 };
-struct devices
+struct graphAccessInfo
+{
+     VkPipelineStageFlags2 stages;
+     VkAccessFlags2 access;
+     VkImageLayout layout;
+     VkBool32 isWrite;
+};
+struct graphResource
+{
+     VkImage image;
+     VkBuffer buffer;
+     unsigned int transient;
+     VkImageLayout layout;
+     VkPipelineStageFlags2 writeStages;
+     VkAccessFlags2 writeAccess;
+     VkPipelineStageFlags2 readStages;
+     VkBool32 isExported;
+     enum graphAccess finalAccess;
+     VkBool32 isNeeded;
+};
+struct graphUsage
+{
+     unsigned int pass;
+     unsigned int resource;
+     enum graphAccess access;
+};
+struct graphPass
+{
+     char const * name;
+     void (* record) (VkCommandBuffer, void *);
+     void * argument;
+     VkBool32 hasSideEffects;
+     VkBool32 isLive;
+};
+struct transientImage
+{
+     VkFormat format;
+     struct point size;
+     VkImageUsageFlags usage;
+     VkImage image;
+     VkMemoryRequirements requirements;
+     VkDeviceSize offset;
+     VkBool32 isBound;
+     VkBool32 isUsed;
+     unsigned int firstPass;
+     unsigned int lastPass;
+};
+struct transients
+{
+     unsigned int count;
+     unsigned int capacity;
+     struct transientImage * images;
+     struct allocation allocation;
+};
+struct graph
+{
+     VkDevice logic;
+     struct allocator * pointerToAllocator;
+     PFN_vkCmdPipelineBarrier2 cmdPipelineBarrier2;
+     unsigned int numberOfResources;
+     unsigned int capacityOfResources;
+     struct graphResource * resources;
+     unsigned int numberOfPasses;
+     unsigned int capacityOfPasses;
+     struct graphPass * passes;
+     unsigned int numberOfUsages;
+     unsigned int capacityOfUsages;
+     struct graphUsage * usages;
+     unsigned int numberOfSlots;
+     unsigned int slot;
+     struct transients * transients;
+     unsigned int capacityOfBarriers;
+     unsigned int numberOfImageBarriers;
+     unsigned int numberOfBufferBarriers;
+     VkImageMemoryBarrier2 * imageBarriers;
+     VkBufferMemoryBarrier2 * bufferBarriers;
+     VkImageMemoryBarrier * legacyImageBarriers;
+     VkBufferMemoryBarrier * legacyBufferBarriers;
+     unsigned int numberOfExecutions;
+     unsigned int passesInTotal;
+     unsigned int culledInTotal;
+     unsigned int barriersInTotal;
+     unsigned int batchesInTotal;
+     unsigned int numberOfPlacements;
+};
+struct retirement
+{
+     VkSwapchainKHR chain;
+     struct images * pointerToImages;
+     uint64_t lastFrame;
+};
+struct retirements
+{
+     unsigned int number;
+     unsigned int capacity;
+     struct retirement * entries;
+     unsigned int numberOfRecreations;
+     double recreationTime;
+};
+struct frames
+{
+     unsigned int const count;
+     VkCommandBuffer * const buffers;
+     VkFence * const inFlight;
+     uint64_t * const timelineValues;
+     uint64_t * const submitted;
+     uint64_t * const completed;
+     uint64_t numberOfSubmits;
+};
+struct worker
+{
+     struct workers * pointerToWorkers;
+     unsigned int index;
+     pthread_t thread;
+     VkCommandPool * pools;
+     double recordingTime;
+     unsigned int numberOfRecordings;
+};
+struct workers
+{
+     VkDevice logic;
+     unsigned int count;
+     unsigned int numberOfSlots;
+     struct worker * workers;
+     VkCommandBuffer * buffers;
+     pthread_mutex_t mutex;
+     pthread_cond_t started;
+     pthread_cond_t finished;
+     unsigned int generation;
+     unsigned int remaining;
+     int isRunning;
+     unsigned int slot;
+     VkRenderPass renderPass;
+     VkFramebuffer framebuffer;
+     VkFormat format;
+     struct point size;
+     VkClearValue clearValue;
+};
+struct drawing
+{
+     VkRenderPass renderPass;
+     VkFramebuffer framebuffer;
+     VkImageView view;
+     VkFormat format;
+     struct point size;
+     VkClearValue clearValue;
+     struct workers * pointerToWorkers;
+     unsigned int slot;
+};
+struct replay
+{
+     VkDevice logic;
+     VkCommandPool pool;
+     unsigned int numberOfSlots;
+     unsigned int numberOfBuffers;
+     VkCommandBuffer * buffers;
+     struct images * pointerToImages;
+     struct point size;
+     VkBuffer parameters;
+     struct allocation parametersAllocation;
+     VkImage * swatches;
+     struct allocation * swatchAllocations;
+     unsigned int numberOfRecordings;
+     double recordingTime;
+};
+struct replayFill
+{
+     VkBuffer parameters;
+     VkDeviceSize offset;
+     VkImage swatch;
+     VkImage target;
+     struct point size;
+};
+struct synchronization
+{
+     VkDevice logic;
+     unsigned int numberOfFences;
+     unsigned int capacityOfFences;
+     VkFence * fences;
+     unsigned int numberOfSemaphores;
+     unsigned int capacityOfSemaphores;
+     VkSemaphore * semaphores;
+     VkSemaphore timeline;
+     uint64_t timelineValue;
+     unsigned int createdInFrame;
+     unsigned int createdInTotal;
+};
+enum phase {PHASE_POLL, PHASE_WAIT, PHASE_ACQUIRE, PHASE_RECORD, PHASE_SUBMIT, PHASE_PRESENT, PHASE_PACE, PHASE_FRAME, PHASE_GPU, NUMBER_OF_PHASES};
+char const * const phaseNames [NUMBER_OF_PHASES] = {"poll", "wait", "acquire", "record", "submit", "present", "pace", "frame", "gpu"};
+struct statistics
+{
+     unsigned int count;
+     double minimum;
+     double mean;
+     double median;
+     double percentile99;
+};
+struct timings
+{
+     unsigned int capacity;
+     unsigned int count;
+     double origin;
+     double lastSummary;
+     unsigned int lastSummaryCount;
+     unsigned int summaryInterval;
+     char const * path;
+     char configuration [128];
+     double * starts;
+     double * durations;
+     VkQueryPool queryPool;
+     double timestampPeriod;
+     uint64_t timestampMask;
+     unsigned int numberOfSlots;
+     unsigned int * pendingFrames;
+};
+struct output
 {
      GLFWwindow * window;
-     VkInstance vulkan;
      VkSurfaceKHR surface;
+     VkSwapchainKHR chain;
+     struct point size;
+     VkPresentModeKHR presentMode;
+     struct images * pointerToImages;
+     struct retirements * pointerToRetirements;
+     struct replay * pointerToReplay;
+     VkSemaphore * imageAvailable;
+     unsigned int imageIndex;
+     int isStale;
+     VkBool32 isDrawn;
+};
+struct devices
+{
+     VkInstance vulkan;
+     VkDebugUtilsMessengerEXT messenger;
      VkPhysicalDevice card;
+     unsigned int version;
      VkDevice logic;
      VkQueue queue;
      unsigned int queueFamilyIndex;
+     VkQueue presentQueue;
+     unsigned int presentQueueFamilyIndex;
+     VkQueue transferQueue;
+     unsigned int transferQueueFamilyIndex;
      VkSurfaceFormatKHR format;
-     VkSwapchainKHR chain;
+     unsigned int numberOfOutputs;
+     struct output * outputs;
+     unsigned int requestedImageCount;
+     enum presentPolicy presentPolicy;
+     VkPresentModeKHR requestedPresentMode;
      VkCommandPool pool;
-     VkCommandBuffer buffer;
      VkRenderPass renderPass;
-     struct images * pointerToImages;
+     struct allocator * pointerToAllocator;
+     struct staging * pointerToStaging;
+     struct arena * pointerToArena;
+     struct capture * pointerToCapture;
+     struct overlay * pointerToOverlay;
+     struct graph * pointerToGraph;
+     VkImageUsageFlags imageUsage;
+     struct frames * pointerToFrames;
+     struct workers * pointerToWorkers;
+     struct synchronization * pointerToSynchronization;
+     struct timings * pointerToTimings;
+     struct pacing * pointerToPacing;
+     struct pipelines * pointerToPipelines;
+     double startupTime;
 };
 
+void logPrint (int const level, char const * const format, ...) __attribute__ ((format (printf, 2, 3)));
+void stopLogging (void);
+
+static volatile sig_atomic_t isInterrupted = 0;
+static atomic_int isDirty = 1;
+static atomic_int isWindowOpen = 0;
+static int logLevel = LOG_INFO;
+static struct logRing logRing;
+char const * const logLevelNames [ ] = {"error", "warning", "info", "debug", "trace"};
+char const * const validationNames [ ] = {"none", "standard", "gpu", "sync"};
+char const * const deviceTypeNames [ ] = {"other", "integrated", "discrete", "virtual", "cpu"};
+char const * const captureFormatNames [ ] = {"ppm", "raw", "stream"};
+struct graphAccessInfo const graphAccesses [NUMBER_OF_GRAPH_ACCESSES] =
+     {[GRAPH_COLOR_ATTACHMENT] = {.stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, .access = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, .isWrite = VK_TRUE},
+      [GRAPH_SAMPLED] = {.stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, .access = VK_ACCESS_2_SHADER_READ_BIT, .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, .isWrite = VK_FALSE},
+      [GRAPH_UNIFORM] = {.stages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, .access = VK_ACCESS_2_UNIFORM_READ_BIT, .layout = VK_IMAGE_LAYOUT_UNDEFINED, .isWrite = VK_FALSE},
+      [GRAPH_TRANSFER_SOURCE] = {.stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT, .access = VK_ACCESS_2_TRANSFER_READ_BIT, .layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, .isWrite = VK_FALSE},
+      [GRAPH_TRANSFER_DESTINATION] = {.stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT, .access = VK_ACCESS_2_TRANSFER_WRITE_BIT, .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, .isWrite = VK_TRUE},
+      [GRAPH_HOST_READ] = {.stages = VK_PIPELINE_STAGE_2_HOST_BIT, .access = VK_ACCESS_2_HOST_READ_BIT, .layout = VK_IMAGE_LAYOUT_GENERAL, .isWrite = VK_FALSE},
+      [GRAPH_PRESENT] = {.stages = VK_PIPELINE_STAGE_2_NONE, .access = VK_ACCESS_2_NONE, .layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, .isWrite = VK_FALSE},
+     };
+static PFN_vkSetDebugUtilsObjectNameEXT setDebugUtilsObjectName = NULL;
+static PFN_vkCmdBeginRendering cmdBeginRendering = NULL;
+static PFN_vkCmdEndRendering cmdEndRendering = NULL;
+
+void interrupt (int const signalNumber)
+{
+     (void) signalNumber;
+     isInterrupted = 1;
+}
+
+void invalidate (void)
+{
+     atomic_store (& isDirty, 1);
+     if (atomic_load (& isWindowOpen)) glfwPostEmptyEvent ( );
+}
+
+void markStale (struct output * const pointerToOutput)
+{
+     pointerToOutput->isStale = 1;
+     atomic_store (& isDirty, 1);
+}
+
+void resize (GLFWwindow * const window, int const width, int const height)
+{
+     logDebug ("Framebuffer resized to %d, %d.", width, height);
+     markStale (glfwGetWindowUserPointer (window));
+     invalidate ( );
+}
+
+void damageOnRefresh (GLFWwindow * const window)
+{
+     (void) window;
+     invalidate ( );
+}
+
+void damageOnFocus (GLFWwindow * const window, int const isFocused)
+{
+     (void) window;
+     (void) isFocused;
+     invalidate ( );
+}
+
+void damageOnKey (GLFWwindow * const window, int const key, int const scancode, int const action, int const modifiers)
+{
+     (void) window;
+     (void) key;
+     (void) scancode;
+     (void) action;
+     (void) modifiers;
+     invalidate ( );
+}
+
+void damageOnButton (GLFWwindow * const window, int const button, int const action, int const modifiers)
+{
+     (void) window;
+     (void) button;
+     (void) action;
+     (void) modifiers;
+     invalidate ( );
+}
+
+void damageOnCursor (GLFWwindow * const window, double const x, double const y)
+{
+     (void) window;
+     (void) x;
+     (void) y;
+     invalidate ( );
+}
+
+void damageOnScroll (GLFWwindow * const window, double const x, double const y)
+{
+     (void) window;
+     (void) x;
+     (void) y;
+     invalidate ( );
+}
+
 void try (int const code, char const * const pointerToLocation)
 {
      if (code)
      {
+          stopLogging ( );
           fprintf (stderr, "Error %d in %s!\n", code, pointerToLocation);
           exit (-1);
      }
@@ -53,234 +697,2618 @@ void * xcalloc (unsigned int count, unsigned int size)
      return pointerToMemory;
 }
 
+void * xrealloc (void * pointerToMemory, unsigned int size)
+{
+     pointerToMemory = realloc (pointerToMemory, size);
+     if (! pointerToMemory)
+     {
+          perror ("xrealloc");
+          exit (EXIT_FAILURE);
+     }
+     return pointerToMemory;
+}
+
 void * xmalloc0 (unsigned int size)
 {
      return xcalloc (1, size);
 }
 
-void checkGlfwError (char const * const pointerToLocation)
+double getTime (void)
 {
-     const char * message;
-     const int code = glfwGetError (&message);
-     if (code) printf ("GLFW error %X, %s in %s.\n", code, message, pointerToLocation);
+     struct timespec time;
+     clock_gettime (CLOCK_MONOTONIC, & time);
+     return time.tv_sec + time.tv_nsec * 1e-9;
 }
 
-VkPhysicalDevice getSomePhysicalDevice (VkInstance const vulkan)
+void sleepUntil (double const deadline)
 {
-     unsigned int numberOfRequiredDevices;
-     try (vkEnumeratePhysicalDevices (vulkan, &numberOfRequiredDevices, NULL), "Vulkan physical device count");
-     try (numberOfRequiredDevices == 0, "No devices at all");
-     VkPhysicalDevice * pointerToCards = xcalloc (numberOfRequiredDevices, sizeof (VkPhysicalDevice));
-     try (vkEnumeratePhysicalDevices (vulkan, &numberOfRequiredDevices, pointerToCards), "Vulkan physical device acquisition");
-     VkPhysicalDevice card = pointerToCards [0];
-     free (pointerToCards);
-     return card;
+     double const wake = deadline - SPIN_SECONDS;
+     if (wake > getTime ( ))
+     {
+          struct timespec const time = {.tv_sec = (time_t) wake, .tv_nsec = (long) ((wake - (time_t) wake) * 1e9)};
+          int result;
+          while ((result = clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, & time, NULL)) == EINTR && ! isInterrupted);
+          if (result) return;
+     }
+     double const end = fmin (deadline, getTime ( ) + SPIN_SECONDS);
+     while (getTime ( ) < end);
 }
 
-void getLogicAndQueue (VkPhysicalDevice const card, VkSurfaceKHR const surface, VkDevice * const pointerToLogic, VkQueue * const pointerToQueue, unsigned int * const pointerToQueueFamilyIndex)
+void pushLog (int const level, char const * const format, va_list arguments)
 {
-     unsigned int numberOfAvailableQueueFamilies;
-     vkGetPhysicalDeviceQueueFamilyProperties (card, &numberOfAvailableQueueFamilies, NULL);
+     unsigned int position = atomic_load_explicit (& logRing.head, memory_order_relaxed);
+     struct logSlot * slot;
+     for (;;)
      {
-          VkQueueFamilyProperties * pointerToQueueFamilies = xcalloc (numberOfAvailableQueueFamilies, sizeof (VkQueueFamilyProperties));
-          vkGetPhysicalDeviceQueueFamilyProperties (card, &numberOfAvailableQueueFamilies, pointerToQueueFamilies);
+          slot = & logRing.slots [position % LOG_RING_SIZE];
+          int const difference = (int) (atomic_load_explicit (& slot->sequence, memory_order_acquire) - position);
+          if (difference == 0 && atomic_compare_exchange_weak_explicit (& logRing.head, & position, position + 1, memory_order_relaxed, memory_order_relaxed)) break;
+          if (difference < 0)
           {
-               *pointerToQueueFamilyIndex = ~(unsigned int)0;
-               for (unsigned int i = 0; i < numberOfAvailableQueueFamilies; ++i)
-                    if (pointerToQueueFamilies [i].queueCount > 0 && pointerToQueueFamilies [i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
-                    {
-                         *pointerToQueueFamilyIndex = i;
-                         break;
-                    }
-               try (*pointerToQueueFamilyIndex == ~(unsigned int)0, "search for a queue");
+               atomic_fetch_add_explicit (& logRing.dropped, 1, memory_order_relaxed);
+               return;
           }
-          free (pointerToQueueFamilies);
+          if (difference > 0) position = atomic_load_explicit (& logRing.head, memory_order_relaxed);
      }
+     slot->level = level;
+     slot->time = getTime ( );
+     vsnprintf (slot->text, LOG_MESSAGE_SIZE, format, arguments);
+     atomic_store_explicit (& slot->sequence, position + 1, memory_order_release);
+}
+
+void writeLog (int const level, double const time, char const * const text)
+{
+     if (level == LOG_INFO) fprintf (stdout, "%s\n", text);
+     else if (level < LOG_INFO) fprintf (stderr, "%s: %s\n", logLevelNames [level], text);
+     else fprintf (stdout, "%.6f %s: %s\n", time, logLevelNames [level], text);
+}
+
+unsigned int flushLog (void)
+{
+     unsigned int count = 0;
+     for (;;)
      {
-          float priority = 1;
-          const VkDeviceQueueCreateInfo queueCreateInfo =
-               {.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-                .pNext = NULL,
-                .flags = 0,
-                .queueFamilyIndex = * pointerToQueueFamilyIndex,
-                .queueCount = 1,
-                .pQueuePriorities = &priority
-               };
-          char const * const extensions[1] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
-          const VkDeviceCreateInfo deviceCreateInfo =
-               {.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-                .pNext = NULL,
-                .flags = 0,
-                .queueCreateInfoCount = 1,
-                .pQueueCreateInfos = &queueCreateInfo,
-                .enabledLayerCount = 0,
-                .ppEnabledLayerNames = NULL,
-                .enabledExtensionCount = 1,
-                .ppEnabledExtensionNames = extensions,
-                .pEnabledFeatures = NULL
-               };
-          try (vkCreateDevice (card, &deviceCreateInfo, NULL, pointerToLogic), "Vulkan logical device initialization");
+          struct logSlot * const slot = & logRing.slots [logRing.tail % LOG_RING_SIZE];
+          if ((int) (atomic_load_explicit (& slot->sequence, memory_order_acquire) - (logRing.tail + 1)) < 0) break;
+          writeLog (slot->level, slot->time, slot->text);
+          atomic_store_explicit (& slot->sequence, logRing.tail + LOG_RING_SIZE, memory_order_release);
+          logRing.tail++;
+          count++;
      }
-     vkGetDeviceQueue (* pointerToLogic, * pointerToQueueFamilyIndex, 0, pointerToQueue);
+     unsigned int const dropped = atomic_exchange_explicit (& logRing.dropped, 0, memory_order_relaxed);
+     if (dropped) fprintf (stdout, "%u log messages dropped.\n", dropped);
+     if (count || dropped) fflush (stdout);
+     return count;
+}
+
+void * runLog (void * const unused)
+{
+     (void) unused;
+     struct timespec const period = {.tv_sec = 0, .tv_nsec = 10000000};
+     while (atomic_load_explicit (& logRing.isRunning, memory_order_acquire))
+          if (! flushLog ( )) nanosleep (& period, NULL);
+     flushLog ( );
+     return NULL;
+}
+
+void logPrint (int const level, char const * const format, ...)
+{
+     if (level > logLevel) return;
+     va_list arguments;
+     va_start (arguments, format);
+     if (atomic_load_explicit (& logRing.isRunning, memory_order_acquire)) pushLog (level, format, arguments);
+     else
      {
-          VkBool32 isSurfaceSupported;
-          try (vkGetPhysicalDeviceSurfaceSupportKHR (card, * pointerToQueueFamilyIndex, surface, &isSurfaceSupported), "Vulkan surface support check");
-          try (isSurfaceSupported == VK_FALSE, "Vulkan surface not supported by queue family");
+          char text [LOG_MESSAGE_SIZE];
+          vsnprintf (text, sizeof (text), format, arguments);
+          writeLog (level, getTime ( ), text);
      }
+     va_end (arguments);
 }
 
-VkSurfaceFormatKHR getFormat (VkPhysicalDevice const card, VkSurfaceKHR const surface)
+void startLogging (void)
 {
-     unsigned int numberOfFormats;
-     try (vkGetPhysicalDeviceSurfaceFormatsKHR (card, surface, &numberOfFormats, NULL), "Vulkan surface formats number query");
-     VkSurfaceFormatKHR format;
+     for (unsigned int i = 0; i < LOG_RING_SIZE; ++i) atomic_init (& logRing.slots [i].sequence, i);
+     atomic_init (& logRing.head, 0);
+     logRing.tail = 0;
+     atomic_init (& logRing.dropped, 0);
+     atomic_init (& logRing.isRunning, 1);
+     if (pthread_create (& logRing.thread, NULL, runLog, NULL))
      {
-          VkSurfaceFormatKHR * pointerToFormats = xcalloc (numberOfFormats, sizeof (VkSurfaceFormatKHR));
-          try (vkGetPhysicalDeviceSurfaceFormatsKHR (card, surface, &numberOfFormats, pointerToFormats), "Vulkan surface formats query");
-          for (unsigned int i = 0; i < numberOfFormats; ++i)
+          perror ("pthread_create");
+          exit (EXIT_FAILURE);
+     }
+     atexit (stopLogging);
+     char const * const value = getenv ("LOG_LEVEL");
+     if (value && * value)
+     {
+          for (unsigned int i = 0; i < sizeof (logLevelNames) / sizeof (logLevelNames [0]); ++i)
+               if (! strcmp (value, logLevelNames [i]) || (value [0] == '0' + (char) i && ! value [1])) logLevel = i;
+          if (logLevel > LOG_LEVEL) logWarning ("Log level %s is compiled out, the most verbose available is %s.", value, logLevelNames [LOG_LEVEL]);
+     }
+}
+
+void stopLogging (void)
+{
+     if (! atomic_exchange_explicit (& logRing.isRunning, 0, memory_order_acq_rel)) return;
+     pthread_join (logRing.thread, NULL);
+}
+
+struct pacing * getPointerToPacing (enum pacingMode const mode, unsigned int const targetRate)
+{
+     struct pacing * pointerToPacing = xmalloc0 (sizeof (struct pacing));
+     pointerToPacing->mode = mode == PACING_TARGET && targetRate == 0 ? PACING_UNLIMITED : mode;
+     pointerToPacing->interval = targetRate ? 1.0 / targetRate : 0;
+     pointerToPacing->deadline = getTime ( );
+     return pointerToPacing;
+}
+
+VkBool32 isWindowClosing (unsigned int const numberOfOutputs, struct output const * const outputs)
+{
+     for (unsigned int i = 0; i < numberOfOutputs; ++i) if (outputs [i].window && glfwWindowShouldClose (outputs [i].window)) return VK_TRUE;
+     return VK_FALSE;
+}
+
+VkBool32 waitForDamage (struct pacing * const pointerToPacing, unsigned int const numberOfOutputs, struct output const * const outputs)
+{
+     if (pointerToPacing->mode != PACING_IDLE) return VK_TRUE;
+     if (! outputs [0].window)
+     {
+          pointerToPacing->damageTime = getTime ( );
+          return VK_TRUE;
+     }
+     while (! atomic_load (& isDirty) && ! isInterrupted && ! isWindowClosing (numberOfOutputs, outputs))
+     {
+          double timeout = IDLE_WAKE_SECONDS;
+          if (pointerToPacing->interval > 0)
           {
-               VkFormatProperties formatProperties;
-               vkGetPhysicalDeviceFormatProperties (card, pointerToFormats [i].format, &formatProperties);
-               printf ("Format available: %u\n", pointerToFormats [i].format);
+               double const remaining = pointerToPacing->deadline - getTime ( );
+               if (remaining <= 0)
+               {
+                    pointerToPacing->deadline = getTime ( ) + pointerToPacing->interval;
+                    atomic_store (& isDirty, 1);
+                    break;
+               }
+               if (remaining < timeout) timeout = remaining;
           }
-          format = pointerToFormats [1];
-          free (pointerToFormats);
+          glfwWaitEventsTimeout (timeout);
+          pointerToPacing->numberOfWakeups++;
      }
-     return format;
+     if (! atomic_exchange (& isDirty, 0)) return VK_FALSE;
+     pointerToPacing->damageTime = getTime ( );
+     return VK_TRUE;
 }
 
-VkSwapchainKHR getSwapchain (VkPhysicalDevice const card, VkDevice const logic, VkSurfaceKHR const surface, VkSurfaceFormatKHR const format, struct point const size)
+void pace (struct pacing * const pointerToPacing)
 {
-     VkSurfaceCapabilitiesKHR capabilities;
-     try (vkGetPhysicalDeviceSurfaceCapabilitiesKHR (card, surface, &capabilities), "Vulkan surface capabilities query");
-     unsigned int numberOfPresentationModes;
-     try (vkGetPhysicalDeviceSurfacePresentModesKHR (card, surface, &numberOfPresentationModes, NULL), "Vulkan surface presentationModes number query");
-     VkPresentModeKHR * pointerToPresentationModes = xcalloc (numberOfPresentationModes, sizeof (VkPresentModeKHR));
-     try (vkGetPhysicalDeviceSurfacePresentModesKHR (card, surface, &numberOfPresentationModes, pointerToPresentationModes), "Vulkan surface presentationModes query");
-     VkPresentModeKHR presentationMode = pointerToPresentationModes [0];
-     free (pointerToPresentationModes);
-     printf ("Smallest extent: %x, %x.\n", capabilities.minImageExtent.width, capabilities.minImageExtent.height);
-     printf ("Largest extent: %x, %x.\n", capabilities.maxImageExtent.width, capabilities.maxImageExtent.height);
-     VkSwapchainKHR chain;
+     if (pointerToPacing->mode == PACING_IDLE)
      {
-          const VkSwapchainCreateInfoKHR info =
-               {.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-                .pNext = NULL,
-                .flags = 0,
-                .surface = surface,
-                .minImageCount = capabilities.minImageCount + 1,
-                .imageFormat = format.format,
-                .imageColorSpace = format.colorSpace,
-                .imageExtent = {.width = size.x, .height = size.y},
-                .imageArrayLayers = 1,
-                .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
-                .queueFamilyIndexCount = 0,
-                .pQueueFamilyIndices = NULL,
-                .preTransform = capabilities.currentTransform,
-                .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-                .presentMode = presentationMode,
-                .clipped = VK_TRUE,
-                .oldSwapchain = VK_NULL_HANDLE,
-               };
-          try (vkCreateSwapchainKHR (logic, &info, NULL, &chain), "Vulkan swapchain acquisition");
+          pointerToPacing->latency += getTime ( ) - pointerToPacing->damageTime;
+          pointerToPacing->numberOfRedraws++;
+     }
+     if (pointerToPacing->mode != PACING_TARGET) return;
+     double const now = getTime ( );
+     pointerToPacing->deadline += pointerToPacing->interval;
+     if (pointerToPacing->deadline < now) pointerToPacing->deadline = now;
+     else sleepUntil (pointerToPacing->deadline);
+}
+
+unsigned int getEnvironmentNumber (char const * const name, unsigned int const fallback)
+{
+     char const * const value = getenv (name);
+     if (! value || ! * value) return fallback;
+     char * end;
+     unsigned long const number = strtoul (value, & end, 10);
+     if (* end)
+     {
+          logWarning ("Ignoring %s=%s, not a number.", name, value);
+          return fallback;
+     }
+     return number;
+}
+
+char const * const presentModeNames [ ] = {"immediate", "mailbox", "fifo", "relaxed"};
+
+char const * const presentPolicyNames [ ] = {"power", "latency", "explicit"};
+
+char const * getPresentModeName (VkPresentModeKHR const presentMode)
+{
+     if ((unsigned int) presentMode < sizeof (presentModeNames) / sizeof (presentModeNames [0])) return presentModeNames [presentMode];
+     return "other";
+}
+
+VkPresentModeKHR getPresentModeByName (char const * const name)
+{
+     if (! name || ! * name) return VK_PRESENT_MODE_MAX_ENUM_KHR;
+     for (unsigned int i = 0; i < sizeof (presentModeNames) / sizeof (presentModeNames [0]); ++i)
+          if (! strcmp (name, presentModeNames [i])) return i;
+     logWarning ("Ignoring unknown present mode %s.", name);
+     return VK_PRESENT_MODE_MAX_ENUM_KHR;
+}
+
+enum presentPolicy getPresentPolicyByName (char const * const name)
+{
+     if (! name || ! * name) return PRESENT_POWER_SAVING;
+     for (unsigned int i = 0; i < sizeof (presentPolicyNames) / sizeof (presentPolicyNames [0]); ++i)
+          if (! strcmp (name, presentPolicyNames [i])) return i;
+     logWarning ("Ignoring unknown present policy %s.", name);
+     return PRESENT_POWER_SAVING;
+}
+
+enum validation getValidationByName (char const * const name)
+{
+     if (! name || ! * name) return VALIDATION_NONE;
+     for (unsigned int i = 0; i < sizeof (validationNames) / sizeof (validationNames [0]); ++i)
+          if (! strcmp (name, validationNames [i])) return i;
+     logWarning ("Ignoring unknown validation %s.", name);
+     return VALIDATION_NONE;
+}
+
+enum captureFormat getCaptureFormatByName (char const * const name)
+{
+     if (! name || ! * name) return CAPTURE_PPM;
+     for (unsigned int i = 0; i < sizeof (captureFormatNames) / sizeof (captureFormatNames [0]); ++i)
+          if (! strcmp (name, captureFormatNames [i])) return i;
+     logWarning ("Ignoring unknown capture format %s.", name);
+     return CAPTURE_PPM;
+}
+
+VkBool32 isLayerAvailable (char const * const name)
+{
+     unsigned int numberOfLayers;
+     try (vkEnumerateInstanceLayerProperties (& numberOfLayers, NULL), "Vulkan layer count");
+     VkLayerProperties * pointerToLayers = xcalloc (numberOfLayers, sizeof (VkLayerProperties));
+     try (vkEnumerateInstanceLayerProperties (& numberOfLayers, pointerToLayers), "Vulkan layer query");
+     VkBool32 isAvailable = VK_FALSE;
+     for (unsigned int i = 0; i < numberOfLayers && ! isAvailable; ++i) isAvailable = ! strcmp (pointerToLayers [i].layerName, name);
+     free (pointerToLayers);
+     return isAvailable;
+}
+
+VkBool32 isInstanceExtensionAvailable (char const * const layer, char const * const name)
+{
+     unsigned int numberOfExtensions;
+     try (vkEnumerateInstanceExtensionProperties (layer, & numberOfExtensions, NULL), "Vulkan instance extension count");
+     VkExtensionProperties * pointerToExtensions = xcalloc (numberOfExtensions, sizeof (VkExtensionProperties));
+     try (vkEnumerateInstanceExtensionProperties (layer, & numberOfExtensions, pointerToExtensions), "Vulkan instance extension query");
+     VkBool32 isAvailable = VK_FALSE;
+     for (unsigned int i = 0; i < numberOfExtensions && ! isAvailable; ++i) isAvailable = ! strcmp (pointerToExtensions [i].extensionName, name);
+     free (pointerToExtensions);
+     return isAvailable;
+}
+
+VkBool32 routeValidationMessage (VkDebugUtilsMessageSeverityFlagBitsEXT const severity, VkDebugUtilsMessageTypeFlagsEXT const type, VkDebugUtilsMessengerCallbackDataEXT const * const pointerToData, void * const pointerToUserData)
+{
+     (void) type;
+     (void) pointerToUserData;
+     char const * const name = pointerToData->pMessageIdName ? pointerToData->pMessageIdName : "message";
+     if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) logError ("Validation %s: %s", name, pointerToData->pMessage);
+     else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) logWarning ("Validation %s: %s", name, pointerToData->pMessage);
+     else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) logDebug ("Validation %s: %s", name, pointerToData->pMessage);
+     else logTrace ("Validation %s: %s", name, pointerToData->pMessage);
+     return VK_FALSE;
+}
+
+void setObjectName (VkDevice const logic, VkObjectType const type, uint64_t const handle, char const * const name)
+{
+     if (! setDebugUtilsObjectName) return;
+     VkDebugUtilsObjectNameInfoEXT const info = {.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT, .pNext = NULL, .objectType = type, .objectHandle = handle, .pObjectName = name};
+     setDebugUtilsObjectName (logic, & info);
+}
+
+void checkGlfwError (char const * const pointerToLocation)
+{
+     const char * message;
+     const int code = glfwGetError (&message);
+     if (code) logError ("GLFW error %X, %s in %s.", code, message, pointerToLocation);
+}
+
+VkBool32 isDeviceExtensionAvailable (VkPhysicalDevice const card, char const * const name)
+{
+     unsigned int numberOfExtensions;
+     try (vkEnumerateDeviceExtensionProperties (card, NULL, & numberOfExtensions, NULL), "Vulkan device extension count");
+     VkExtensionProperties * pointerToExtensions = xcalloc (numberOfExtensions, sizeof (VkExtensionProperties));
+     try (vkEnumerateDeviceExtensionProperties (card, NULL, & numberOfExtensions, pointerToExtensions), "Vulkan device extension query");
+     VkBool32 isAvailable = VK_FALSE;
+     for (unsigned int i = 0; i < numberOfExtensions && ! isAvailable; ++i) isAvailable = ! strcmp (pointerToExtensions [i].extensionName, name);
+     free (pointerToExtensions);
+     return isAvailable;
+}
+
+void formatUUID (uint8_t const * const uuid, char * const buffer)
+{
+     for (unsigned int i = 0; i < VK_UUID_SIZE; ++i) snprintf (buffer + 2 * i, 3, "%02x", uuid [i]);
+}
+
+VkBool32 hasQueueFamilies (VkInstance const vulkan, VkPhysicalDevice const card, VkBool32 const isPresenting)
+{
+     unsigned int numberOfFamilies;
+     vkGetPhysicalDeviceQueueFamilyProperties (card, & numberOfFamilies, NULL);
+     VkQueueFamilyProperties * pointerToFamilies = xcalloc (numberOfFamilies, sizeof (VkQueueFamilyProperties));
+     vkGetPhysicalDeviceQueueFamilyProperties (card, & numberOfFamilies, pointerToFamilies);
+     VkBool32 isGraphics = VK_FALSE, isPresent = ! isPresenting;
+     for (unsigned int i = 0; i < numberOfFamilies; ++i)
+     {
+          if (pointerToFamilies [i].queueCount > 0 && pointerToFamilies [i].queueFlags & VK_QUEUE_GRAPHICS_BIT) isGraphics = VK_TRUE;
+          if (isPresenting && glfwGetPhysicalDevicePresentationSupport (vulkan, card, i)) isPresent = VK_TRUE;
+     }
+     free (pointerToFamilies);
+     return isGraphics && isPresent;
+}
+
+unsigned int scorePhysicalDevice (VkInstance const vulkan, VkPhysicalDevice const card, VkBool32 const isPresenting)
+{
+     if (isPresenting && ! isDeviceExtensionAvailable (card, VK_KHR_SWAPCHAIN_EXTENSION_NAME)) return 0;
+     if (! hasQueueFamilies (vulkan, card, isPresenting)) return 0;
+     VkPhysicalDeviceProperties properties;
+     vkGetPhysicalDeviceProperties (card, & properties);
+     VkPhysicalDeviceMemoryProperties memory;
+     vkGetPhysicalDeviceMemoryProperties (card, & memory);
+     unsigned int score = 1;
+     if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) score += 4000;
+     else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) score += 2000;
+     else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU) score += 1000;
+     VkDeviceSize largestHeap = 0;
+     for (unsigned int i = 0; i < memory.memoryHeapCount; ++i)
+          if (memory.memoryHeaps [i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT && memory.memoryHeaps [i].size > largestHeap) largestHeap = memory.memoryHeaps [i].size;
+     score += largestHeap >> 26;
+     score += properties.limits.maxImageDimension2D >> 10;
+     return score;
+}
+
+VkBool32 isDeviceRequested (VkPhysicalDevice const card, unsigned int const instanceVersion, char const * const name)
+{
+     VkPhysicalDeviceProperties properties;
+     vkGetPhysicalDeviceProperties (card, & properties);
+     if (strstr (properties.deviceName, name)) return VK_TRUE;
+     if (instanceVersion < VK_API_VERSION_1_1 || properties.apiVersion < VK_API_VERSION_1_1) return VK_FALSE;
+     VkPhysicalDeviceIDProperties identifiers = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES, .pNext = NULL};
+     VkPhysicalDeviceProperties2 properties2 = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = & identifiers};
+     vkGetPhysicalDeviceProperties2 (card, & properties2);
+     char uuid [2 * VK_UUID_SIZE + 1];
+     formatUUID (identifiers.deviceUUID, uuid);
+     return ! strcmp (uuid, name);
+}
+
+VkPhysicalDevice getPhysicalDevice (VkInstance const vulkan, unsigned int const instanceVersion, VkBool32 const isPresenting, char const * const name)
+{
+     unsigned int numberOfRequiredDevices;
+     try (vkEnumeratePhysicalDevices (vulkan, &numberOfRequiredDevices, NULL), "Vulkan physical device count");
+     try (numberOfRequiredDevices == 0, "No devices at all");
+     VkPhysicalDevice * pointerToCards = xcalloc (numberOfRequiredDevices, sizeof (VkPhysicalDevice));
+     try (vkEnumeratePhysicalDevices (vulkan, &numberOfRequiredDevices, pointerToCards), "Vulkan physical device acquisition");
+     VkPhysicalDevice card = VK_NULL_HANDLE, requestedCard = VK_NULL_HANDLE;
+     unsigned int bestScore = 0;
+     for (unsigned int i = 0; i < numberOfRequiredDevices; ++i)
+     {
+          VkPhysicalDeviceProperties properties;
+          vkGetPhysicalDeviceProperties (pointerToCards [i], & properties);
+          unsigned int const score = scorePhysicalDevice (vulkan, pointerToCards [i], isPresenting);
+          logInfo ("Device %u: %s, %s, score %u", i, properties.deviceName, properties.deviceType <= VK_PHYSICAL_DEVICE_TYPE_CPU ? deviceTypeNames [properties.deviceType] : "unknown", score);
+          if (score && name && * name && requestedCard == VK_NULL_HANDLE && isDeviceRequested (pointerToCards [i], instanceVersion, name)) requestedCard = pointerToCards [i];
+          if (score > bestScore)
+          {
+               bestScore = score;
+               card = pointerToCards [i];
+          }
+     }
+     free (pointerToCards);
+     if (name && * name && requestedCard == VK_NULL_HANDLE) logWarning ("No usable device matches %s, choosing by score.", name);
+     if (requestedCard != VK_NULL_HANDLE) card = requestedCard;
+     try (card == VK_NULL_HANDLE, "No usable device");
+     return card;
+}
+
+unsigned int getInstanceVersion (void)
+{
+     unsigned int version;
+     try (vkEnumerateInstanceVersion (& version), "Vulkan instance version query");
+     return version < VK_API_VERSION_1_3 ? version : VK_API_VERSION_1_3;
+}
+
+unsigned int getDeviceVersion (VkPhysicalDevice const card, unsigned int const instanceVersion)
+{
+     VkPhysicalDeviceProperties properties;
+     vkGetPhysicalDeviceProperties (card, & properties);
+     return properties.apiVersion < instanceVersion ? properties.apiVersion : instanceVersion;
+}
+
+VkBool32 isTimelineSupported (VkPhysicalDevice const card, unsigned int const version)
+{
+     if (version < VK_API_VERSION_1_2) return VK_FALSE;
+     VkPhysicalDeviceTimelineSemaphoreFeatures timeline = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES, .pNext = NULL, .timelineSemaphore = VK_FALSE};
+     VkPhysicalDeviceFeatures2 features = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = & timeline};
+     vkGetPhysicalDeviceFeatures2 (card, & features);
+     return timeline.timelineSemaphore;
+}
+
+void getLogicAndQueues (VkInstance const vulkan, VkPhysicalDevice const card, VkBool32 const isPresenting, VkBool32 const isAsyncTransferEnabled, void const * const pointerToFeatures, struct devices * const pointerToDevices)
+{
+     unsigned int const none = ~(unsigned int)0;
+     unsigned int graphics = none, present = none, transfer = none;
+     unsigned int numberOfAvailableQueueFamilies;
+     vkGetPhysicalDeviceQueueFamilyProperties (card, &numberOfAvailableQueueFamilies, NULL);
+     VkQueueFamilyProperties * pointerToQueueFamilies = xcalloc (numberOfAvailableQueueFamilies, sizeof (VkQueueFamilyProperties));
+     vkGetPhysicalDeviceQueueFamilyProperties (card, &numberOfAvailableQueueFamilies, pointerToQueueFamilies);
+     for (unsigned int i = 0; i < numberOfAvailableQueueFamilies; ++i)
+     {
+          VkQueueFlags const flags = pointerToQueueFamilies [i].queueCount > 0 ? pointerToQueueFamilies [i].queueFlags : 0;
+          VkBool32 const canPresent = isPresenting && glfwGetPhysicalDevicePresentationSupport (vulkan, card, i);
+          if (flags & VK_QUEUE_GRAPHICS_BIT && (graphics == none || (canPresent && present != graphics)))
+          {
+               graphics = i;
+               if (canPresent) present = i;
+          }
+          if (canPresent && present == none) present = i;
+          if (flags & VK_QUEUE_TRANSFER_BIT && ! (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && transfer == none) transfer = i;
+     }
+     try (graphics == none, "search for a queue");
+     try (isPresenting && present == none, "search for a present queue");
+     if (! isAsyncTransferEnabled) transfer = none;
+     unsigned int const graphicsCount = present == graphics && pointerToQueueFamilies [graphics].queueCount > 1 ? 2 : 1;
+     free (pointerToQueueFamilies);
+     {
+          float const priorities [2] = {1, 1};
+          unsigned int numberOfQueueCreateInfos = 0;
+          VkDeviceQueueCreateInfo queueCreateInfos [3];
+          unsigned int const families [3] = {graphics, present, transfer};
+          for (unsigned int i = 0; i < 3; ++i)
+          {
+               VkBool32 isRepeated = families [i] == none;
+               for (unsigned int j = 0; j < i; ++j) isRepeated = isRepeated || families [j] == families [i];
+               if (isRepeated) continue;
+               queueCreateInfos [numberOfQueueCreateInfos++] = (VkDeviceQueueCreateInfo)
+                    {.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                     .pNext = NULL,
+                     .flags = 0,
+                     .queueFamilyIndex = families [i],
+                     .queueCount = families [i] == graphics ? graphicsCount : 1,
+                     .pQueuePriorities = priorities,
+                    };
+          }
+          char const * const extensions[1] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+          unsigned int const numberOfExtensions = isPresenting ? 1 : 0;
+          const VkDeviceCreateInfo deviceCreateInfo =
+               {.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+                .pNext = pointerToFeatures,
+                .flags = 0,
+                .queueCreateInfoCount = numberOfQueueCreateInfos,
+                .pQueueCreateInfos = queueCreateInfos,
+                .enabledLayerCount = 0,
+                .ppEnabledLayerNames = NULL,
+                .enabledExtensionCount = numberOfExtensions,
+                .ppEnabledExtensionNames = extensions,
+                .pEnabledFeatures = NULL
+               };
+          try (vkCreateDevice (card, &deviceCreateInfo, NULL, & pointerToDevices->logic), "Vulkan logical device initialization");
+     }
+     VkDevice const logic = pointerToDevices->logic;
+     pointerToDevices->queueFamilyIndex = graphics;
+     vkGetDeviceQueue (logic, graphics, 0, & pointerToDevices->queue);
+     pointerToDevices->presentQueueFamilyIndex = present;
+     pointerToDevices->presentQueue = VK_NULL_HANDLE;
+     if (present != none) vkGetDeviceQueue (logic, present, present == graphics ? graphicsCount - 1 : 0, & pointerToDevices->presentQueue);
+     pointerToDevices->transferQueueFamilyIndex = transfer;
+     pointerToDevices->transferQueue = VK_NULL_HANDLE;
+     if (transfer != none) vkGetDeviceQueue (logic, transfer, 0, & pointerToDevices->transferQueue);
+     logInfo ("Queues: graphics in family %u, present %s%s, transfer %s", graphics,
+              present == none ? "none" : present == graphics ? "in the same family" : "in its own family", present == graphics && graphicsCount > 1 ? " on a second queue" : "",
+              transfer == none ? "shared with graphics" : "dedicated");
+}
+
+void checkSurfaceSupport (VkPhysicalDevice const card, unsigned int const queueFamilyIndex, VkSurfaceKHR const surface)
+{
+     VkBool32 isSurfaceSupported;
+     try (vkGetPhysicalDeviceSurfaceSupportKHR (card, queueFamilyIndex, surface, &isSurfaceSupported), "Vulkan surface support check");
+     try (isSurfaceSupported == VK_FALSE, "Vulkan surface not supported by queue family");
+}
+
+VkSurfaceFormatKHR getFormat (VkPhysicalDevice const card, VkSurfaceKHR const surface)
+{
+     unsigned int numberOfFormats;
+     try (vkGetPhysicalDeviceSurfaceFormatsKHR (card, surface, &numberOfFormats, NULL), "Vulkan surface formats number query");
+     VkSurfaceFormatKHR format;
+     {
+          VkSurfaceFormatKHR * pointerToFormats = xcalloc (numberOfFormats, sizeof (VkSurfaceFormatKHR));
+          try (vkGetPhysicalDeviceSurfaceFormatsKHR (card, surface, &numberOfFormats, pointerToFormats), "Vulkan surface formats query");
+          for (unsigned int i = 0; i < numberOfFormats; ++i)
+          {
+               VkFormatProperties formatProperties;
+               vkGetPhysicalDeviceFormatProperties (card, pointerToFormats [i].format, &formatProperties);
+               logDebug ("Format available: %u", pointerToFormats [i].format);
+          }
+          format = pointerToFormats [1];
+          free (pointerToFormats);
+     }
+     return format;
+}
+VkBool32 isSurfaceFormatAvailable (VkPhysicalDevice const card, VkSurfaceKHR const surface, VkSurfaceFormatKHR const format)
+{
+     unsigned int numberOfFormats;
+     try (vkGetPhysicalDeviceSurfaceFormatsKHR (card, surface, &numberOfFormats, NULL), "Vulkan surface formats number query");
+     VkSurfaceFormatKHR * pointerToFormats = xcalloc (numberOfFormats, sizeof (VkSurfaceFormatKHR));
+     try (vkGetPhysicalDeviceSurfaceFormatsKHR (card, surface, &numberOfFormats, pointerToFormats), "Vulkan surface formats query");
+     VkBool32 isAvailable = VK_FALSE;
+     for (unsigned int i = 0; i < numberOfFormats; ++i) if (pointerToFormats [i].format == format.format && pointerToFormats [i].colorSpace == format.colorSpace) isAvailable = VK_TRUE;
+     free (pointerToFormats);
+     return isAvailable;
+}
+
+VkSurfaceFormatKHR getHeadlessFormat (VkPhysicalDevice const card)
+{
+     VkFormat const candidates [ ] = {VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM};
+     for (unsigned int i = 0; i < sizeof (candidates) / sizeof (candidates [0]); ++i)
+     {
+          VkFormatProperties formatProperties;
+          vkGetPhysicalDeviceFormatProperties (card, candidates [i], &formatProperties);
+          if (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT)
+               return (VkSurfaceFormatKHR) {.format = candidates [i], .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+     }
+     try (1, "search for a headless format");
+     return (VkSurfaceFormatKHR) {.format = VK_FORMAT_UNDEFINED, .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+}
+
+VkBool32 isBlitSupported (VkPhysicalDevice const card, VkFormat const source, VkFormat const destination)
+{
+     VkFormatProperties sourceProperties, destinationProperties;
+     vkGetPhysicalDeviceFormatProperties (card, source, & sourceProperties);
+     vkGetPhysicalDeviceFormatProperties (card, destination, & destinationProperties);
+     return sourceProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT && destinationProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT;
+}
+
+unsigned int getMemoryType (VkPhysicalDevice const card, unsigned int const typeBits, VkMemoryPropertyFlags const flags)
+{
+     VkPhysicalDeviceMemoryProperties properties;
+     vkGetPhysicalDeviceMemoryProperties (card, & properties);
+     for (unsigned int i = 0; i < properties.memoryTypeCount; ++i)
+          if (typeBits & (1u << i) && (properties.memoryTypes [i].propertyFlags & flags) == flags) return i;
+     try (1, "search for a memory type");
+     return 0;
+}
+
+unsigned int getBuddyOrder (VkDeviceSize const size, VkDeviceSize const leafSize)
+{
+     unsigned int order = 0;
+     while ((leafSize << order) < size) ++order;
+     return order;
+}
+
+struct allocator * getPointerToAllocator (VkPhysicalDevice const card, VkDevice const logic)
+{
+     VkPhysicalDeviceProperties properties;
+     vkGetPhysicalDeviceProperties (card, & properties);
+     struct allocator * pointerToAllocator = xmalloc0 (sizeof (struct allocator));
+     pointerToAllocator->card = card;
+     pointerToAllocator->logic = logic;
+     pointerToAllocator->blockSize = MEMORY_BLOCK_SIZE;
+     pointerToAllocator->leafSize = MEMORY_LEAF_SIZE << getBuddyOrder (properties.limits.bufferImageGranularity, MEMORY_LEAF_SIZE);
+     pointerToAllocator->maximumAllocationCount = properties.limits.maxMemoryAllocationCount;
+     logDebug ("Memory blocks of %llu bytes in leaves of %llu bytes.", (unsigned long long) pointerToAllocator->blockSize, (unsigned long long) pointerToAllocator->leafSize);
+     return pointerToAllocator;
+}
+
+struct memoryBlock * getMemoryBlock (struct allocator * const pointerToAllocator, unsigned int const memoryType, VkDeviceSize const size)
+{
+     try (pointerToAllocator->numberOfBlocks >= pointerToAllocator->maximumAllocationCount, "Device memory allocation count");
+     struct memoryBlock * pointerToBlock = xmalloc0 (sizeof (struct memoryBlock));
+     pointerToBlock->memoryType = memoryType;
+     pointerToBlock->size = size;
+     pointerToBlock->leafSize = pointerToAllocator->leafSize;
+     pointerToBlock->order = getBuddyOrder (size, pointerToBlock->leafSize);
+     unsigned int const numberOfNodes = (2u << pointerToBlock->order) - 1;
+     pointerToBlock->longest = xcalloc (numberOfNodes, sizeof (unsigned char));
+     for (unsigned int node = 0, level = 0; node < numberOfNodes; ++node)
+     {
+          if (node + 1 == 2u << level) ++level;
+          pointerToBlock->longest [node] = pointerToBlock->order - level + 1;
+     }
+     {
+          VkMemoryAllocateInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .pNext = NULL,
+                .allocationSize = size,
+                .memoryTypeIndex = memoryType,
+               };
+          try (vkAllocateMemory (pointerToAllocator->logic, & info, NULL, & pointerToBlock->memory), "Allocating a device memory block");
+     }
+     nameObject (pointerToAllocator->logic, VK_OBJECT_TYPE_DEVICE_MEMORY, pointerToBlock->memory, "memory block");
+     VkPhysicalDeviceMemoryProperties properties;
+     vkGetPhysicalDeviceMemoryProperties (pointerToAllocator->card, & properties);
+     if (properties.memoryTypes [memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+          try (vkMapMemory (pointerToAllocator->logic, pointerToBlock->memory, 0, VK_WHOLE_SIZE, 0, & pointerToBlock->pointer), "Mapping a device memory block");
+     if (pointerToAllocator->numberOfBlocks == pointerToAllocator->capacityOfBlocks)
+     {
+          pointerToAllocator->capacityOfBlocks = pointerToAllocator->capacityOfBlocks ? 2 * pointerToAllocator->capacityOfBlocks : 8;
+          pointerToAllocator->blocks = xrealloc (pointerToAllocator->blocks, pointerToAllocator->capacityOfBlocks * sizeof (struct memoryBlock *));
+     }
+     pointerToAllocator->blocks [pointerToAllocator->numberOfBlocks++] = pointerToBlock;
+     pointerToAllocator->blocksInTotal++;
+     logDebug ("Memory block of %llu bytes in type %u.", (unsigned long long) size, memoryType);
+     return pointerToBlock;
+}
+
+void leaveMemoryBlock (struct allocator * const pointerToAllocator, struct memoryBlock * const pointerToBlock)
+{
+     unsigned int i = 0;
+     while (pointerToAllocator->blocks [i] != pointerToBlock) ++i;
+     pointerToAllocator->blocks [i] = pointerToAllocator->blocks [-- pointerToAllocator->numberOfBlocks];
+     vkFreeMemory (pointerToAllocator->logic, pointerToBlock->memory, NULL);
+     free (pointerToBlock->longest);
+     free (pointerToBlock);
+}
+
+void updateBuddy (struct memoryBlock * const pointerToBlock, unsigned int const node, unsigned int const order)
+{
+     unsigned char const left = pointerToBlock->longest [2 * node + 1];
+     unsigned char const right = pointerToBlock->longest [2 * node + 2];
+     if (left == order && right == order) pointerToBlock->longest [node] = order + 1;
+     else pointerToBlock->longest [node] = left > right ? left : right;
+}
+
+VkBool32 takeBuddy (struct memoryBlock * const pointerToBlock, unsigned int const order, VkDeviceSize * const pointerToOffset)
+{
+     if (order > pointerToBlock->order || pointerToBlock->longest [0] < order + 1) return VK_FALSE;
+     unsigned int node = 0;
+     unsigned int nodeOrder = pointerToBlock->order;
+     for (; nodeOrder != order; --nodeOrder) node = pointerToBlock->longest [2 * node + 1] >= order + 1 ? 2 * node + 1 : 2 * node + 2;
+     pointerToBlock->longest [node] = 0;
+     * pointerToOffset = (node + 1 - (1u << (pointerToBlock->order - order))) * (pointerToBlock->leafSize << order);
+     while (node)
+     {
+          node = (node - 1) / 2;
+          updateBuddy (pointerToBlock, node, ++nodeOrder);
+     }
+     return VK_TRUE;
+}
+
+void giveBuddy (struct memoryBlock * const pointerToBlock, VkDeviceSize const offset, unsigned int const order)
+{
+     unsigned int node = (1u << (pointerToBlock->order - order)) - 1 + offset / (pointerToBlock->leafSize << order);
+     unsigned int nodeOrder = order;
+     pointerToBlock->longest [node] = order + 1;
+     while (node)
+     {
+          node = (node - 1) / 2;
+          updateBuddy (pointerToBlock, node, ++nodeOrder);
+     }
+}
+
+struct allocation getAllocation (struct allocator * const pointerToAllocator, VkMemoryRequirements const requirements, VkMemoryPropertyFlags const flags)
+{
+     unsigned int const memoryType = getMemoryType (pointerToAllocator->card, requirements.memoryTypeBits, flags);
+     unsigned int const order = getBuddyOrder (requirements.size > requirements.alignment ? requirements.size : requirements.alignment, pointerToAllocator->leafSize);
+     struct allocation allocation = {.pointerToBlock = NULL, .size = pointerToAllocator->leafSize << order, .requestedSize = requirements.size};
+     for (unsigned int i = 0; i < pointerToAllocator->numberOfBlocks && ! allocation.pointerToBlock; ++i)
+          if (pointerToAllocator->blocks [i]->memoryType == memoryType && takeBuddy (pointerToAllocator->blocks [i], order, & allocation.offset))
+               allocation.pointerToBlock = pointerToAllocator->blocks [i];
+     if (! allocation.pointerToBlock)
+     {
+          allocation.pointerToBlock = getMemoryBlock (pointerToAllocator, memoryType, allocation.size > pointerToAllocator->blockSize ? allocation.size : pointerToAllocator->blockSize);
+          takeBuddy (allocation.pointerToBlock, order, & allocation.offset);
+     }
+     allocation.memory = allocation.pointerToBlock->memory;
+     allocation.pointer = allocation.pointerToBlock->pointer ? (char *) allocation.pointerToBlock->pointer + allocation.offset : NULL;
+     allocation.pointerToBlock->used += allocation.size;
+     allocation.pointerToBlock->numberOfAllocations++;
+     pointerToAllocator->requested += requirements.size;
+     pointerToAllocator->numberOfAllocations++;
+     pointerToAllocator->allocationsInTotal++;
+     return allocation;
+}
+
+void giveAllocation (struct allocator * const pointerToAllocator, struct allocation const allocation)
+{
+     struct memoryBlock * const pointerToBlock = allocation.pointerToBlock;
+     giveBuddy (pointerToBlock, allocation.offset, getBuddyOrder (allocation.size, pointerToBlock->leafSize));
+     pointerToBlock->used -= allocation.size;
+     pointerToBlock->numberOfAllocations--;
+     pointerToAllocator->requested -= allocation.requestedSize;
+     pointerToAllocator->numberOfAllocations--;
+     if (! pointerToBlock->numberOfAllocations && pointerToBlock->size > pointerToAllocator->blockSize) leaveMemoryBlock (pointerToAllocator, pointerToBlock);
+}
+
+struct memoryStatistics getMemoryStatistics (struct allocator const * const pointerToAllocator)
+{
+     struct memoryStatistics statistics = {.numberOfBlocks = pointerToAllocator->numberOfBlocks, .numberOfAllocations = pointerToAllocator->numberOfAllocations, .requested = pointerToAllocator->requested};
+     VkDeviceSize largestFreeSum = 0;
+     for (unsigned int i = 0; i < pointerToAllocator->numberOfBlocks; ++i)
+     {
+          struct memoryBlock const * const pointerToBlock = pointerToAllocator->blocks [i];
+          VkDeviceSize const largestFree = pointerToBlock->longest [0] ? pointerToBlock->leafSize << (pointerToBlock->longest [0] - 1) : 0;
+          statistics.reserved += pointerToBlock->size;
+          statistics.used += pointerToBlock->used;
+          largestFreeSum += largestFree;
+          if (largestFree > statistics.largestFree) statistics.largestFree = largestFree;
+     }
+     VkDeviceSize const freeBytes = statistics.reserved - statistics.used;
+     statistics.fragmentation = freeBytes ? 1 - (double) largestFreeSum / freeBytes : 0;
+     return statistics;
+}
+
+void leaveAllocator (struct allocator * const pointerToAllocator)
+{
+     struct memoryStatistics const statistics = getMemoryStatistics (pointerToAllocator);
+     logInfo ("Device memory: %u blocks created, %u allocations made, %.1f MiB reserved at exit", pointerToAllocator->blocksInTotal, pointerToAllocator->allocationsInTotal, statistics.reserved / 1048576.0);
+     if (pointerToAllocator->numberOfAllocations) logWarning ("%u device memory allocations were never given back.", pointerToAllocator->numberOfAllocations);
+     while (pointerToAllocator->numberOfBlocks) leaveMemoryBlock (pointerToAllocator, pointerToAllocator->blocks [0]);
+     free (pointerToAllocator->blocks);
+     free (pointerToAllocator);
+}
+
+VkBuffer getDataBuffer (VkDevice const logic, struct allocator * const pointerToAllocator, VkDeviceSize const size, VkBufferUsageFlags const usage, VkMemoryPropertyFlags const flags, struct allocation * const pointerToAllocation)
+{
+     VkBuffer buffer;
+     {
+          VkBufferCreateInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                .pNext = NULL,
+                .flags = 0,
+                .size = size,
+                .usage = usage,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .queueFamilyIndexCount = 0,
+                .pQueueFamilyIndices = NULL,
+               };
+          try (vkCreateBuffer (logic, & info, NULL, & buffer), "Creating a buffer");
+     }
+     VkMemoryRequirements requirements;
+     vkGetBufferMemoryRequirements (logic, buffer, & requirements);
+     * pointerToAllocation = getAllocation (pointerToAllocator, requirements, flags);
+     try (vkBindBufferMemory (logic, buffer, pointerToAllocation->memory, pointerToAllocation->offset), "Binding buffer memory");
+     return buffer;
+}
+
+struct arena * getPointerToArena (VkDevice const logic, struct allocator * const pointerToAllocator, VkBufferUsageFlags const usage, VkMemoryPropertyFlags const flags, VkDeviceSize const bytesPerSlot, unsigned int const numberOfSlots)
+{
+     struct arena * pointerToArena = xmalloc0 (sizeof (struct arena));
+     pointerToArena->numberOfSlots = numberOfSlots;
+     pointerToArena->bytesPerSlot = (bytesPerSlot + pointerToAllocator->leafSize - 1) / pointerToAllocator->leafSize * pointerToAllocator->leafSize;
+     pointerToArena->heads = xcalloc (numberOfSlots, sizeof (VkDeviceSize));
+     pointerToArena->buffer = getDataBuffer (logic, pointerToAllocator, pointerToArena->bytesPerSlot * numberOfSlots, usage, flags, & pointerToArena->allocation);
+     return pointerToArena;
+}
+
+VkBool32 takeFromArena (struct arena * const pointerToArena, unsigned int const slot, VkDeviceSize const size, VkDeviceSize const alignment, VkDeviceSize * const pointerToOffset)
+{
+     VkDeviceSize const base = slot * pointerToArena->bytesPerSlot;
+     VkDeviceSize const step = alignment ? alignment : 1;
+     VkDeviceSize const offset = (base + pointerToArena->heads [slot] + step - 1) / step * step;
+     if (offset + size > base + pointerToArena->bytesPerSlot)
+     {
+          logWarning ("Arena slot %u is out of space for %llu bytes.", slot, (unsigned long long) size);
+          return VK_FALSE;
+     }
+     pointerToArena->heads [slot] = offset + size - base;
+     if (pointerToArena->heads [slot] > pointerToArena->peak) pointerToArena->peak = pointerToArena->heads [slot];
+     * pointerToOffset = offset;
+     return VK_TRUE;
+}
+
+void * getArenaPointer (struct arena const * const pointerToArena, VkDeviceSize const offset)
+{
+     return pointerToArena->allocation.pointer ? (char *) pointerToArena->allocation.pointer + offset : NULL;
+}
+
+void resetArena (struct arena * const pointerToArena, unsigned int const slot)
+{
+     pointerToArena->heads [slot] = 0;
+}
+
+void leaveArena (VkDevice const logic, struct allocator * const pointerToAllocator, struct arena * const pointerToArena)
+{
+     logDebug ("Arena peak use: %llu of %llu bytes per slot.", (unsigned long long) pointerToArena->peak, (unsigned long long) pointerToArena->bytesPerSlot);
+     vkDestroyBuffer (logic, pointerToArena->buffer, NULL);
+     giveAllocation (pointerToAllocator, pointerToArena->allocation);
+     free (pointerToArena->heads);
+     free (pointerToArena);
+}
+
+VkBool32 isPresentModeAvailable (VkPresentModeKHR const * const pointerToPresentationModes, unsigned int const numberOfPresentationModes, VkPresentModeKHR const presentMode)
+{
+     for (unsigned int i = 0; i < numberOfPresentationModes; ++i) if (pointerToPresentationModes [i] == presentMode) return VK_TRUE;
+     return VK_FALSE;
+}
+
+VkPresentModeKHR choosePresentMode (VkPresentModeKHR const * const pointerToPresentationModes, unsigned int const numberOfPresentationModes, enum presentPolicy const policy, VkPresentModeKHR const requestedPresentMode)
+{
+     if (policy == PRESENT_EXPLICIT)
+     {
+          if (isPresentModeAvailable (pointerToPresentationModes, numberOfPresentationModes, requestedPresentMode)) return requestedPresentMode;
+          logWarning ("Present mode %s is not available, using fifo.", getPresentModeName (requestedPresentMode));
+     }
+     if (policy == PRESENT_LOWEST_LATENCY)
+     {
+          VkPresentModeKHR const preferences [ ] = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+          for (unsigned int i = 0; i < sizeof (preferences) / sizeof (preferences [0]); ++i)
+               if (isPresentModeAvailable (pointerToPresentationModes, numberOfPresentationModes, preferences [i])) return preferences [i];
+          logWarning ("Neither mailbox nor immediate presentation is available, using fifo.");
+     }
+     return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+VkSwapchainKHR getSwapchain (VkPhysicalDevice const card, VkDevice const logic, VkSurfaceKHR const surface, VkSurfaceFormatKHR const format, struct point * const pointerToSize, unsigned int const imageCount, enum presentPolicy const policy, VkPresentModeKHR const requestedPresentMode, VkImageUsageFlags const usage, unsigned int const * const queueFamilyIndices, VkSwapchainKHR const oldChain, VkPresentModeKHR * const pointerToPresentMode)
+{
+     VkSurfaceCapabilitiesKHR capabilities;
+     try (vkGetPhysicalDeviceSurfaceCapabilitiesKHR (card, surface, &capabilities), "Vulkan surface capabilities query");
+     unsigned int numberOfPresentationModes;
+     try (vkGetPhysicalDeviceSurfacePresentModesKHR (card, surface, &numberOfPresentationModes, NULL), "Vulkan surface presentationModes number query");
+     VkPresentModeKHR * pointerToPresentationModes = xcalloc (numberOfPresentationModes, sizeof (VkPresentModeKHR));
+     try (vkGetPhysicalDeviceSurfacePresentModesKHR (card, surface, &numberOfPresentationModes, pointerToPresentationModes), "Vulkan surface presentationModes query");
+     for (unsigned int i = 0; i < numberOfPresentationModes; ++i) logDebug ("Present mode available: %s", getPresentModeName (pointerToPresentationModes [i]));
+     VkPresentModeKHR const presentationMode = choosePresentMode (pointerToPresentationModes, numberOfPresentationModes, policy, requestedPresentMode);
+     free (pointerToPresentationModes);
+     * pointerToPresentMode = presentationMode;
+     unsigned int minImageCount = imageCount ? imageCount : capabilities.minImageCount + 1;
+     if (minImageCount < capabilities.minImageCount) minImageCount = capabilities.minImageCount;
+     if (capabilities.maxImageCount && minImageCount > capabilities.maxImageCount) minImageCount = capabilities.maxImageCount;
+     if (imageCount && minImageCount != imageCount)
+          logWarning ("Requested %u swapchain images, the surface allows %u to %u, asking for %u.", imageCount, capabilities.minImageCount, capabilities.maxImageCount, minImageCount);
+     logDebug ("Smallest extent: %u, %u.", capabilities.minImageExtent.width, capabilities.minImageExtent.height);
+     logDebug ("Largest extent: %u, %u.", capabilities.maxImageExtent.width, capabilities.maxImageExtent.height);
+     if (capabilities.currentExtent.width != UINT32_MAX)
+     {
+          pointerToSize->x = capabilities.currentExtent.width;
+          pointerToSize->y = capabilities.currentExtent.height;
+     }
+     else
+     {
+          if ((unsigned int) pointerToSize->x < capabilities.minImageExtent.width) pointerToSize->x = capabilities.minImageExtent.width;
+          if ((unsigned int) pointerToSize->x > capabilities.maxImageExtent.width) pointerToSize->x = capabilities.maxImageExtent.width;
+          if ((unsigned int) pointerToSize->y < capabilities.minImageExtent.height) pointerToSize->y = capabilities.minImageExtent.height;
+          if ((unsigned int) pointerToSize->y > capabilities.maxImageExtent.height) pointerToSize->y = capabilities.maxImageExtent.height;
+     }
+     VkSwapchainKHR chain;
+     {
+          const VkSwapchainCreateInfoKHR info =
+               {.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+                .pNext = NULL,
+                .flags = 0,
+                .surface = surface,
+                .minImageCount = minImageCount,
+                .imageFormat = format.format,
+                .imageColorSpace = format.colorSpace,
+                .imageExtent = {.width = pointerToSize->x, .height = pointerToSize->y},
+                .imageArrayLayers = 1,
+                .imageUsage = usage,
+                .imageSharingMode = queueFamilyIndices [0] != queueFamilyIndices [1] ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+                .queueFamilyIndexCount = queueFamilyIndices [0] != queueFamilyIndices [1] ? 2 : 0,
+                .pQueueFamilyIndices = queueFamilyIndices,
+                .preTransform = capabilities.currentTransform,
+                .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+                .presentMode = presentationMode,
+                .clipped = VK_TRUE,
+                .oldSwapchain = oldChain,
+               };
+          try (vkCreateSwapchainKHR (logic, &info, NULL, &chain), "Vulkan swapchain acquisition");
+     }
+     nameObject (logic, VK_OBJECT_TYPE_SWAPCHAIN_KHR, chain, "swapchain");
+     return chain;
+}
+
+VkSemaphore getSemaphore (VkDevice const logic)
+{
+     VkSemaphore semaphore;
+     {
+          VkSemaphoreCreateInfo const info = {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, .pNext = NULL, .flags = 0};
+          try (vkCreateSemaphore (logic, & info, NULL, & semaphore), "Get a semaphore");
+     }
+     return semaphore;
+}
+
+VkFence getFence (VkDevice const logic, VkFenceCreateFlags const flags)
+{
+     VkFence fence;
+     {
+          VkFenceCreateInfo const info = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, .pNext = NULL, .flags = flags};
+          try (vkCreateFence (logic, & info, NULL, & fence), "Get a fence");
+     }
+     return fence;
+}
+
+struct synchronization * getPointerToSynchronization (VkDevice const logic, VkBool32 const isTimelineSupported)
+{
+     struct synchronization * pointerToSynchronization = xmalloc0 (sizeof (struct synchronization));
+     pointerToSynchronization->logic = logic;
+     pointerToSynchronization->timeline = VK_NULL_HANDLE;
+     if (isTimelineSupported)
+     {
+          VkSemaphoreTypeCreateInfo const type = {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO, .pNext = NULL, .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE, .initialValue = 0};
+          VkSemaphoreCreateInfo const info = {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, .pNext = & type, .flags = 0};
+          try (vkCreateSemaphore (logic, & info, NULL, & pointerToSynchronization->timeline), "Get a timeline semaphore");
+          nameObject (logic, VK_OBJECT_TYPE_SEMAPHORE, pointerToSynchronization->timeline, "frame timeline");
+     }
+     return pointerToSynchronization;
+}
+
+VkFence takeFence (struct synchronization * const pointerToSynchronization)
+{
+     if (pointerToSynchronization->numberOfFences) return pointerToSynchronization->fences [-- pointerToSynchronization->numberOfFences];
+     pointerToSynchronization->createdInFrame++;
+     pointerToSynchronization->createdInTotal++;
+     return getFence (pointerToSynchronization->logic, 0);
+}
+
+void giveFence (struct synchronization * const pointerToSynchronization, VkFence const fence)
+{
+     try (vkResetFences (pointerToSynchronization->logic, 1, & fence), "Resetting a recycled fence");
+     if (pointerToSynchronization->numberOfFences == pointerToSynchronization->capacityOfFences)
+     {
+          pointerToSynchronization->capacityOfFences = pointerToSynchronization->capacityOfFences ? 2 * pointerToSynchronization->capacityOfFences : 8;
+          pointerToSynchronization->fences = xrealloc (pointerToSynchronization->fences, pointerToSynchronization->capacityOfFences * sizeof (VkFence));
+     }
+     pointerToSynchronization->fences [pointerToSynchronization->numberOfFences++] = fence;
+}
+
+VkSemaphore takeSemaphore (struct synchronization * const pointerToSynchronization)
+{
+     if (pointerToSynchronization->numberOfSemaphores) return pointerToSynchronization->semaphores [-- pointerToSynchronization->numberOfSemaphores];
+     pointerToSynchronization->createdInFrame++;
+     pointerToSynchronization->createdInTotal++;
+     return getSemaphore (pointerToSynchronization->logic);
+}
+
+void giveSemaphore (struct synchronization * const pointerToSynchronization, VkSemaphore const semaphore)
+{
+     if (pointerToSynchronization->numberOfSemaphores == pointerToSynchronization->capacityOfSemaphores)
+     {
+          pointerToSynchronization->capacityOfSemaphores = pointerToSynchronization->capacityOfSemaphores ? 2 * pointerToSynchronization->capacityOfSemaphores : 8;
+          pointerToSynchronization->semaphores = xrealloc (pointerToSynchronization->semaphores, pointerToSynchronization->capacityOfSemaphores * sizeof (VkSemaphore));
+     }
+     pointerToSynchronization->semaphores [pointerToSynchronization->numberOfSemaphores++] = semaphore;
+}
+
+void leaveSynchronization (struct synchronization * const pointerToSynchronization)
+{
+     for (unsigned int i = 0; i < pointerToSynchronization->numberOfFences; ++i) vkDestroyFence (pointerToSynchronization->logic, pointerToSynchronization->fences [i], NULL);
+     for (unsigned int i = 0; i < pointerToSynchronization->numberOfSemaphores; ++i) vkDestroySemaphore (pointerToSynchronization->logic, pointerToSynchronization->semaphores [i], NULL);
+     if (pointerToSynchronization->timeline != VK_NULL_HANDLE) vkDestroySemaphore (pointerToSynchronization->logic, pointerToSynchronization->timeline, NULL);
+     free (pointerToSynchronization->fences);
+     free (pointerToSynchronization->semaphores);
+     free (pointerToSynchronization);
+}
+
+struct images * getPointerToImages (VkDevice const logic, struct synchronization * const pointerToSynchronization, unsigned int const count, VkImage * const images, struct allocation * const allocations, VkFormat const format, VkRenderPass const renderPass, struct point const size)
+{
+     VkImageView * views = xcalloc (count, sizeof (VkImageView));
+     VkFramebuffer * frames = renderPass != VK_NULL_HANDLE ? xcalloc (count, sizeof (VkFramebuffer)) : NULL;
+     VkSemaphore * renderFinished = xcalloc (count, sizeof (VkSemaphore));
+     for (unsigned int i = 0; i < count; ++i)
+     {
+          logDebug ("Initializing image %u.", i);
+          {
+               VkComponentMapping components =
+                    {.r = VK_COMPONENT_SWIZZLE_R,
+                     .g = VK_COMPONENT_SWIZZLE_G,
+                     .b = VK_COMPONENT_SWIZZLE_B,
+                     .a = VK_COMPONENT_SWIZZLE_A,
+                    };
+               VkImageSubresourceRange subresourceRange =
+                    {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                     .baseMipLevel = 0,
+                     .levelCount = 1,
+                     .baseArrayLayer = 0,
+                     .layerCount = 1
+                    };
+               VkImageViewCreateInfo info =
+                    {.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                     .pNext = NULL,
+                     .flags = 0,
+                     .image = images [i],
+                     .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                     .format = format,
+                     .components = components,
+                     .subresourceRange = subresourceRange,
+                    };
+               try (vkCreateImageView (logic, & info, NULL, & views [i]), "Creating image view");
+               logDebug ("Initializing image view %u at %p.", i, (void *) & images [i]);
+          }
+          if (frames)
+          {
+               VkFramebufferCreateInfo info =
+                    {.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+                     .pNext = NULL,
+                     .flags = 0,
+                     .renderPass = renderPass,
+                     .attachmentCount = 1,
+                     .pAttachments = & views [i],
+                     .width = size.x,
+                     .height = size.y,
+                     .layers = 1,
+                    };
+               try (vkCreateFramebuffer (logic, & info, NULL, & frames [i]), "Creating framebuffer");
+               logDebug ("Initializing framebuffer %u at %p.", i, (void *) & frames [i]);
+          }
+          renderFinished [i] = takeSemaphore (pointerToSynchronization);
+     }
+     struct images * pointerToMemory = xmalloc0 (sizeof (struct images));
+     struct images temporaryStructure = {.count = count, .views = views, .images = images, .allocations = allocations, .frames = frames, .renderFinished = renderFinished};
+     memcpy (pointerToMemory, & temporaryStructure, sizeof (temporaryStructure));
+     logDebug ("pointer to views: %p.", (void *) pointerToMemory->views);
+     return pointerToMemory;
+}
+
+struct images * getPointerToSwapchainImages (VkDevice const logic, struct synchronization * const pointerToSynchronization, VkSwapchainKHR const swapchain, VkFormat const format, VkRenderPass const renderPass, struct point const size)
+{
+     unsigned int count;
+     try (vkGetSwapchainImagesKHR (logic, swapchain, &count, NULL), "Get image count");
+     VkImage * images = xcalloc (count, sizeof (VkImage));
+     try (vkGetSwapchainImagesKHR (logic, swapchain, &count, images), "Get images");
+     return getPointerToImages (logic, pointerToSynchronization, count, images, NULL, format, renderPass, size);
+}
+
+struct images * getPointerToHeadlessImages (struct allocator * const pointerToAllocator, VkDevice const logic, struct synchronization * const pointerToSynchronization, unsigned int const count, VkFormat const format, VkImageUsageFlags const usage, VkRenderPass const renderPass, struct point const size)
+{
+     VkImage * images = xcalloc (count, sizeof (VkImage));
+     struct allocation * allocations = xcalloc (count, sizeof (struct allocation));
+     for (unsigned int i = 0; i < count; ++i)
+     {
+          {
+               VkImageCreateInfo const info =
+                    {.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                     .pNext = NULL,
+                     .flags = 0,
+                     .imageType = VK_IMAGE_TYPE_2D,
+                     .format = format,
+                     .extent = {.width = size.x, .height = size.y, .depth = 1},
+                     .mipLevels = 1,
+                     .arrayLayers = 1,
+                     .samples = VK_SAMPLE_COUNT_1_BIT,
+                     .tiling = VK_IMAGE_TILING_OPTIMAL,
+                     .usage = usage,
+                     .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                     .queueFamilyIndexCount = 0,
+                     .pQueueFamilyIndices = NULL,
+                     .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                    };
+               try (vkCreateImage (logic, & info, NULL, & images [i]), "Creating headless image");
+               nameObject (logic, VK_OBJECT_TYPE_IMAGE, images [i], "headless image");
+          }
+          {
+               VkMemoryRequirements requirements;
+               vkGetImageMemoryRequirements (logic, images [i], & requirements);
+               allocations [i] = getAllocation (pointerToAllocator, requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+               try (vkBindImageMemory (logic, images [i], allocations [i].memory, allocations [i].offset), "Binding headless image memory");
+          }
+     }
+     return getPointerToImages (logic, pointerToSynchronization, count, images, allocations, format, renderPass, size);
+}
+
+void leaveImages (VkDevice const logic, struct allocator * const pointerToAllocator, struct images * const pointerToImages)
+{
+     for (unsigned int i = 0; i < pointerToImages->count; ++i)
+     {
+          vkDestroyImageView (logic, pointerToImages->views [i], NULL);
+          if (pointerToImages->frames) vkDestroyFramebuffer (logic, pointerToImages->frames [i], NULL);
+          vkDestroySemaphore (logic, pointerToImages->renderFinished [i], NULL);
+          if (pointerToImages->allocations)
+          {
+               vkDestroyImage (logic, pointerToImages->images [i], NULL);
+               giveAllocation (pointerToAllocator, pointerToImages->allocations [i]);
+          }
+     }
+     free (pointerToImages->images);
+     free (pointerToImages->allocations);
+     free (pointerToImages->views);
+     free (pointerToImages->frames);
+     free (pointerToImages->renderFinished);
+     free (pointerToImages);
+}
+
+VkCommandPool getPool (VkDevice const logic, unsigned int const queueFamilyIndex, VkCommandPoolCreateFlags const flags)
+{
+     VkCommandPool pool;
+     {
+          VkCommandPoolCreateInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .pNext = NULL,
+                .flags = flags,
+                .queueFamilyIndex = queueFamilyIndex,
+               };
+          try (vkCreateCommandPool (logic, &info, NULL, &pool), "Vulkan command pool acquisition");
+     }
+     return pool;
+}
+
+VkCommandBuffer getBuffer (VkDevice const logic, VkCommandPool const pool, VkCommandBufferLevel const level)
+{
+     VkCommandBuffer buffer;
+     {
+          VkCommandBufferAllocateInfo info =
+               {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .pNext = NULL,
+                .commandPool = pool,
+                .level = level,
+                .commandBufferCount = 1,
+               };
+               try (vkAllocateCommandBuffers (logic, &info, &buffer), "Vulkan command buffer allocation");
+     }
+     return buffer;
+}
+
+struct frames * getPointerToFrames (VkDevice const logic, VkCommandPool const pool, unsigned int const count)
+{
+     try (count == 0, "Frames in flight count");
+     VkCommandBuffer * buffers = xcalloc (count, sizeof (VkCommandBuffer));
+     VkFence * inFlight = xcalloc (count, sizeof (VkFence));
+     uint64_t * timelineValues = xcalloc (count, sizeof (uint64_t));
+     uint64_t * submitted = xcalloc (count, sizeof (uint64_t));
+     uint64_t * completed = xcalloc (count, sizeof (uint64_t));
+     for (unsigned int i = 0; i < count; ++i)
+     {
+          buffers [i] = getBuffer (logic, pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+          nameObject (logic, VK_OBJECT_TYPE_COMMAND_BUFFER, buffers [i], "frame command buffer");
+          inFlight [i] = VK_NULL_HANDLE;
+     }
+     struct frames * pointerToMemory = xmalloc0 (sizeof (struct frames));
+     struct frames temporaryStructure = {.count = count, .buffers = buffers, .inFlight = inFlight, .timelineValues = timelineValues, .submitted = submitted, .completed = completed, .numberOfSubmits = 0};
+     memcpy (pointerToMemory, & temporaryStructure, sizeof (temporaryStructure));
+     return pointerToMemory;
+}
+
+void waitForFrame (VkDevice const logic, struct frames * const pointerToFrames, struct synchronization * const pointerToSynchronization, unsigned int const slot)
+{
+     if (pointerToSynchronization->timeline != VK_NULL_HANDLE)
+     {
+          VkSemaphoreWaitInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .pNext = NULL,
+                .flags = 0,
+                .semaphoreCount = 1,
+                .pSemaphores = & pointerToSynchronization->timeline,
+                .pValues = & pointerToFrames->timelineValues [slot],
+               };
+          try (vkWaitSemaphores (logic, & info, -1), "Waiting for the frame slot to retire");
+     }
+     else if (pointerToFrames->inFlight [slot] != VK_NULL_HANDLE)
+     {
+          try (vkWaitForFences (logic, 1, & pointerToFrames->inFlight [slot], VK_TRUE, -1), "Waiting for the frame slot to retire");
+          giveFence (pointerToSynchronization, pointerToFrames->inFlight [slot]);
+          pointerToFrames->inFlight [slot] = VK_NULL_HANDLE;
+     }
+     pointerToFrames->completed [slot] = pointerToFrames->submitted [slot];
+}
+
+VkBool32 isFrameCompleted (struct frames const * const pointerToFrames, uint64_t const frame)
+{
+     for (unsigned int i = 0; i < pointerToFrames->count; ++i)
+          if (pointerToFrames->completed [i] <= frame) return VK_FALSE;
+     return VK_TRUE;
+}
+
+struct staging * getPointerToStaging (VkDevice const logic, struct allocator * const pointerToAllocator, struct frames * const pointerToFrames, struct synchronization * const pointerToSynchronization, VkQueue const transferQueue, unsigned int const transferQueueFamilyIndex, unsigned int const graphicsQueueFamilyIndex, VkDeviceSize const size)
+{
+     struct staging * pointerToStaging = xmalloc0 (sizeof (struct staging));
+     pointerToStaging->logic = logic;
+     pointerToStaging->pointerToFrames = pointerToFrames;
+     pointerToStaging->pointerToSynchronization = pointerToSynchronization;
+     pointerToStaging->numberOfSlots = pointerToFrames->count;
+     pointerToStaging->transferQueue = transferQueue;
+     pointerToStaging->transferQueueFamilyIndex = transferQueueFamilyIndex;
+     pointerToStaging->graphicsQueueFamilyIndex = graphicsQueueFamilyIndex;
+     if (transferQueue != VK_NULL_HANDLE)
+     {
+          pointerToStaging->transferPool = getPool (logic, transferQueueFamilyIndex, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+          pointerToStaging->transferBuffers = xcalloc (pointerToStaging->numberOfSlots, sizeof (VkCommandBuffer));
+          pointerToStaging->uploaded = xcalloc (pointerToStaging->numberOfSlots, sizeof (VkSemaphore));
+          for (unsigned int i = 0; i < pointerToStaging->numberOfSlots; ++i)
+          {
+               pointerToStaging->transferBuffers [i] = getBuffer (logic, pointerToStaging->transferPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+               nameObject (logic, VK_OBJECT_TYPE_COMMAND_BUFFER, pointerToStaging->transferBuffers [i], "transfer command buffer");
+               pointerToStaging->uploaded [i] = getSemaphore (logic);
+          }
+     }
+     pointerToStaging->size = size;
+     pointerToStaging->buffer = getDataBuffer (logic, pointerToAllocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, & pointerToStaging->allocation);
+     nameObject (logic, VK_OBJECT_TYPE_BUFFER, pointerToStaging->buffer, "staging ring");
+     pointerToStaging->ends = xcalloc (pointerToStaging->numberOfSlots, sizeof (uint64_t));
+     pointerToStaging->origin = getTime ( );
+     return pointerToStaging;
+}
+
+void beginStaging (struct staging * const pointerToStaging, unsigned int const slot)
+{
+     pointerToStaging->slot = slot;
+     if (pointerToStaging->ends [slot] > pointerToStaging->tail) pointerToStaging->tail = pointerToStaging->ends [slot];
+}
+
+void * takeStaging (struct staging * const pointerToStaging, VkDeviceSize const size, VkDeviceSize const alignment, VkDeviceSize * const pointerToOffset)
+{
+     VkDeviceSize const step = alignment ? alignment : 1;
+     uint64_t start = (pointerToStaging->head + step - 1) / step * step;
+     if (start % pointerToStaging->size + size > pointerToStaging->size) start = (start / pointerToStaging->size + 1) * pointerToStaging->size;
+     for (unsigned int i = 1; start + size - pointerToStaging->tail > pointerToStaging->size; ++i)
+     {
+          if (i >= pointerToStaging->numberOfSlots)
+          {
+               logWarning ("The staging ring cannot fit %llu more bytes in this frame.", (unsigned long long) size);
+               return NULL;
+          }
+          unsigned int const slot = (pointerToStaging->slot + i) % pointerToStaging->numberOfSlots;
+          double const stallStart = getTime ( );
+          waitForFrame (pointerToStaging->logic, pointerToStaging->pointerToFrames, pointerToStaging->pointerToSynchronization, slot);
+          pointerToStaging->stallTime += getTime ( ) - stallStart;
+          pointerToStaging->numberOfStalls++;
+          if (pointerToStaging->ends [slot] > pointerToStaging->tail) pointerToStaging->tail = pointerToStaging->ends [slot];
+     }
+     pointerToStaging->head = start + size;
+     pointerToStaging->bytesInTotal += size;
+     * pointerToOffset = start % pointerToStaging->size;
+     return (char *) pointerToStaging->allocation.pointer + * pointerToOffset;
+}
+
+void stageBufferCopy (struct staging * const pointerToStaging, VkDeviceSize const sourceOffset, VkBuffer const destination, VkDeviceSize const destinationOffset, VkDeviceSize const size)
+{
+     if (pointerToStaging->numberOfBufferCopies == pointerToStaging->capacityOfBufferCopies)
+     {
+          pointerToStaging->capacityOfBufferCopies = pointerToStaging->capacityOfBufferCopies ? 2 * pointerToStaging->capacityOfBufferCopies : 16;
+          pointerToStaging->bufferDestinations = xrealloc (pointerToStaging->bufferDestinations, pointerToStaging->capacityOfBufferCopies * sizeof (VkBuffer));
+          pointerToStaging->bufferRegions = xrealloc (pointerToStaging->bufferRegions, pointerToStaging->capacityOfBufferCopies * sizeof (VkBufferCopy));
+          pointerToStaging->bufferBarriers = xrealloc (pointerToStaging->bufferBarriers, pointerToStaging->capacityOfBufferCopies * sizeof (VkBufferMemoryBarrier));
+     }
+     pointerToStaging->bufferDestinations [pointerToStaging->numberOfBufferCopies] = destination;
+     pointerToStaging->bufferRegions [pointerToStaging->numberOfBufferCopies++] = (VkBufferCopy) {.srcOffset = sourceOffset, .dstOffset = destinationOffset, .size = size};
+}
+
+void transferStaging (struct staging * const pointerToStaging, VkCommandBuffer const buffer, VkCommandBuffer const graphicsBuffer)
+{
+     unsigned int const numberOfBuffers = pointerToStaging->numberOfBufferCopies;
+     for (unsigned int i = 0; i < numberOfBuffers; ++i)
+          pointerToStaging->bufferBarriers [i] = (VkBufferMemoryBarrier)
+               {.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .pNext = NULL,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = 0,
+                .srcQueueFamilyIndex = pointerToStaging->transferQueueFamilyIndex,
+                .dstQueueFamilyIndex = pointerToStaging->graphicsQueueFamilyIndex,
+                .buffer = pointerToStaging->bufferDestinations [i],
+                .offset = pointerToStaging->bufferRegions [i].dstOffset,
+                .size = pointerToStaging->bufferRegions [i].size,
+               };
+     vkCmdPipelineBarrier (buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, numberOfBuffers, pointerToStaging->bufferBarriers, 0, NULL);
+     for (unsigned int i = 0; i < numberOfBuffers; ++i)
+     {
+          pointerToStaging->bufferBarriers [i].srcAccessMask = 0;
+          pointerToStaging->bufferBarriers [i].dstAccessMask = STAGING_CONSUMER_ACCESS;
+     }
+     vkCmdPipelineBarrier (graphicsBuffer, STAGING_CONSUMER_STAGES, STAGING_CONSUMER_STAGES, 0, 0, NULL, numberOfBuffers, pointerToStaging->bufferBarriers, 0, NULL);
+}
+
+VkSemaphore endStaging (struct staging * const pointerToStaging, VkCommandBuffer const graphicsBuffer)
+{
+     unsigned int const numberOfCopies = pointerToStaging->numberOfBufferCopies;
+     VkBool32 const isTransferQueue = pointerToStaging->transferQueue != VK_NULL_HANDLE && numberOfCopies;
+     VkCommandBuffer const buffer = isTransferQueue ? pointerToStaging->transferBuffers [pointerToStaging->slot] : graphicsBuffer;
+     if (isTransferQueue)
+     {
+          VkCommandBufferBeginInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = NULL,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                .pInheritanceInfo = NULL,
+               };
+          try (vkBeginCommandBuffer (buffer, & info), "Begin transfer buffer");
+     }
+     for (unsigned int i = 0, end; i < pointerToStaging->numberOfBufferCopies; i = end)
+     {
+          VkBuffer const destination = pointerToStaging->bufferDestinations [i];
+          end = i + 1;
+          for (unsigned int j = end; j < pointerToStaging->numberOfBufferCopies; ++j)
+               if (pointerToStaging->bufferDestinations [j] == destination)
+               {
+                    VkBufferCopy const region = pointerToStaging->bufferRegions [j];
+                    pointerToStaging->bufferDestinations [j] = pointerToStaging->bufferDestinations [end];
+                    pointerToStaging->bufferRegions [j] = pointerToStaging->bufferRegions [end];
+                    pointerToStaging->bufferDestinations [end] = destination;
+                    pointerToStaging->bufferRegions [end++] = region;
+               }
+          vkCmdCopyBuffer (buffer, pointerToStaging->buffer, destination, end - i, & pointerToStaging->bufferRegions [i]);
+     }
+     VkSemaphore uploaded = VK_NULL_HANDLE;
+     if (isTransferQueue)
+     {
+          transferStaging (pointerToStaging, buffer, graphicsBuffer);
+          try (vkEndCommandBuffer (buffer), "End transfer buffer");
+          uploaded = pointerToStaging->uploaded [pointerToStaging->slot];
+          VkSubmitInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .pNext = NULL,
+                .waitSemaphoreCount = 0,
+                .pWaitSemaphores = NULL,
+                .pWaitDstStageMask = NULL,
+                .commandBufferCount = 1,
+                .pCommandBuffers = & buffer,
+                .signalSemaphoreCount = 1,
+                .pSignalSemaphores = & uploaded,
+               };
+          try (vkQueueSubmit (pointerToStaging->transferQueue, 1, & info, VK_NULL_HANDLE), "Submission of the uploads to the transfer queue");
+          pointerToStaging->numberOfTransfers++;
+     }
+     else if (numberOfCopies)
+     {
+          VkMemoryBarrier const barrier =
+               {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .pNext = NULL,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = STAGING_CONSUMER_ACCESS,
+               };
+          vkCmdPipelineBarrier (buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, STAGING_CONSUMER_STAGES, 0, 1, & barrier, 0, NULL, 0, NULL);
+     }
+     pointerToStaging->numberOfBufferCopies = 0;
+     pointerToStaging->ends [pointerToStaging->slot] = pointerToStaging->head;
+     return uploaded;
+}
+
+double getStagingBandwidth (struct staging const * const pointerToStaging)
+{
+     double const seconds = getTime ( ) - pointerToStaging->origin;
+     return seconds > 0 ? pointerToStaging->bytesInTotal / 1048576.0 / seconds : 0;
+}
+
+void leaveStaging (struct allocator * const pointerToAllocator, struct staging * const pointerToStaging)
+{
+     logInfo ("Staging ring: %.2f MiB uploaded at %.3f MiB/s, %u transfer queue submissions, %u stalls taking %.2f ms", pointerToStaging->bytesInTotal / 1048576.0, getStagingBandwidth (pointerToStaging),
+              pointerToStaging->numberOfTransfers, pointerToStaging->numberOfStalls, 1e3 * pointerToStaging->stallTime);
+     if (pointerToStaging->transferQueue != VK_NULL_HANDLE)
+     {
+          for (unsigned int i = 0; i < pointerToStaging->numberOfSlots; ++i) vkDestroySemaphore (pointerToStaging->logic, pointerToStaging->uploaded [i], NULL);
+          vkDestroyCommandPool (pointerToStaging->logic, pointerToStaging->transferPool, NULL);
+          free (pointerToStaging->transferBuffers);
+          free (pointerToStaging->uploaded);
+     }
+     vkDestroyBuffer (pointerToStaging->logic, pointerToStaging->buffer, NULL);
+     giveAllocation (pointerToAllocator, pointerToStaging->allocation);
+     free (pointerToStaging->ends);
+     free (pointerToStaging->bufferDestinations);
+     free (pointerToStaging->bufferRegions);
+     free (pointerToStaging->bufferBarriers);
+     free (pointerToStaging);
+}
+
+VkBool32 isSynchronization2Supported (VkPhysicalDevice const card, unsigned int const version)
+{
+     if (version < VK_API_VERSION_1_3) return VK_FALSE;
+     VkPhysicalDeviceSynchronization2Features synchronization2 = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES, .pNext = NULL, .synchronization2 = VK_FALSE};
+     VkPhysicalDeviceFeatures2 features = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = & synchronization2};
+     vkGetPhysicalDeviceFeatures2 (card, & features);
+     return synchronization2.synchronization2;
+}
+
+VkBool32 isDynamicRenderingSupported (VkPhysicalDevice const card, unsigned int const version)
+{
+     if (version < VK_API_VERSION_1_3) return VK_FALSE;
+     VkPhysicalDeviceDynamicRenderingFeatures dynamicRendering = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES, .pNext = NULL, .dynamicRendering = VK_FALSE};
+     VkPhysicalDeviceFeatures2 features = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = & dynamicRendering};
+     vkGetPhysicalDeviceFeatures2 (card, & features);
+     return dynamicRendering.dynamicRendering;
+}
+
+struct graph * getPointerToGraph (VkDevice const logic, struct allocator * const pointerToAllocator, unsigned int const numberOfSlots, VkBool32 const isSynchronization2)
+{
+     struct graph * pointerToGraph = xmalloc0 (sizeof (struct graph));
+     pointerToGraph->logic = logic;
+     pointerToGraph->pointerToAllocator = pointerToAllocator;
+     pointerToGraph->numberOfSlots = numberOfSlots;
+     pointerToGraph->transients = xcalloc (numberOfSlots, sizeof (struct transients));
+     if (isSynchronization2) pointerToGraph->cmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2) vkGetDeviceProcAddr (logic, "vkCmdPipelineBarrier2");
+     logInfo ("Render graph barriers: %s", pointerToGraph->cmdPipelineBarrier2 ? "synchronization2" : "legacy");
+     return pointerToGraph;
+}
+
+void resetGraph (struct graph * const pointerToGraph, unsigned int const slot)
+{
+     pointerToGraph->numberOfResources = 0;
+     pointerToGraph->numberOfPasses = 0;
+     pointerToGraph->numberOfUsages = 0;
+     pointerToGraph->slot = slot;
+     struct transients * const pointerToTransients = & pointerToGraph->transients [slot];
+     for (unsigned int i = 0; i < pointerToTransients->count; ++i) pointerToTransients->images [i].isUsed = VK_FALSE;
+}
+
+unsigned int addGraphResource (struct graph * const pointerToGraph, VkImage const image, VkBuffer const buffer, VkImageLayout const layout, VkPipelineStageFlags2 const stages)
+{
+     if (pointerToGraph->numberOfResources == pointerToGraph->capacityOfResources)
+     {
+          pointerToGraph->capacityOfResources = pointerToGraph->capacityOfResources ? 2 * pointerToGraph->capacityOfResources : 16;
+          pointerToGraph->resources = xrealloc (pointerToGraph->resources, pointerToGraph->capacityOfResources * sizeof (struct graphResource));
+     }
+     pointerToGraph->resources [pointerToGraph->numberOfResources] = (struct graphResource)
+          {.image = image,
+           .buffer = buffer,
+           .transient = ~0u,
+           .layout = layout,
+           .writeStages = stages,
+           .writeAccess = VK_ACCESS_2_NONE,
+           .readStages = VK_PIPELINE_STAGE_2_NONE,
+           .isExported = VK_FALSE,
+           .isNeeded = VK_FALSE,
+          };
+     return pointerToGraph->numberOfResources++;
+}
+
+unsigned int importImage (struct graph * const pointerToGraph, VkImage const image, VkImageLayout const layout, VkPipelineStageFlags2 const stages)
+{
+     return addGraphResource (pointerToGraph, image, VK_NULL_HANDLE, layout, stages);
+}
+
+unsigned int importBuffer (struct graph * const pointerToGraph, VkBuffer const buffer)
+{
+     return addGraphResource (pointerToGraph, VK_NULL_HANDLE, buffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_NONE);
+}
+
+void exportResource (struct graph * const pointerToGraph, unsigned int const resource, enum graphAccess const access)
+{
+     pointerToGraph->resources [resource].isExported = VK_TRUE;
+     pointerToGraph->resources [resource].finalAccess = access;
+}
+
+VkImage getTransientImage (VkDevice const logic, struct transientImage const * const pointerToTransient)
+{
+     VkImage image;
+     VkImageCreateInfo const info =
+          {.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+           .pNext = NULL,
+           .flags = 0,
+           .imageType = VK_IMAGE_TYPE_2D,
+           .format = pointerToTransient->format,
+           .extent = {.width = pointerToTransient->size.x, .height = pointerToTransient->size.y, .depth = 1},
+           .mipLevels = 1,
+           .arrayLayers = 1,
+           .samples = VK_SAMPLE_COUNT_1_BIT,
+           .tiling = VK_IMAGE_TILING_OPTIMAL,
+           .usage = pointerToTransient->usage,
+           .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+           .queueFamilyIndexCount = 0,
+           .pQueueFamilyIndices = NULL,
+           .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+          };
+     try (vkCreateImage (logic, & info, NULL, & image), "Creating a transient image");
+     nameObject (logic, VK_OBJECT_TYPE_IMAGE, image, "transient image");
+     return image;
+}
+
+unsigned int addTransientImage (struct graph * const pointerToGraph, VkFormat const format, struct point const size, VkImageUsageFlags const usage)
+{
+     struct transients * const pointerToTransients = & pointerToGraph->transients [pointerToGraph->slot];
+     unsigned int index = pointerToTransients->count;
+     for (unsigned int i = 0; i < pointerToTransients->count && index == pointerToTransients->count; ++i)
+     {
+          struct transientImage const * const pointerToTransient = & pointerToTransients->images [i];
+          if (! pointerToTransient->isUsed && pointerToTransient->format == format && pointerToTransient->size.x == size.x && pointerToTransient->size.y == size.y && pointerToTransient->usage == usage) index = i;
+     }
+     if (index == pointerToTransients->count)
+     {
+          if (pointerToTransients->count == pointerToTransients->capacity)
+          {
+               pointerToTransients->capacity = pointerToTransients->capacity ? 2 * pointerToTransients->capacity : 8;
+               pointerToTransients->images = xrealloc (pointerToTransients->images, pointerToTransients->capacity * sizeof (struct transientImage));
+          }
+          struct transientImage * const pointerToTransient = & pointerToTransients->images [pointerToTransients->count++];
+          * pointerToTransient = (struct transientImage) {.format = format, .size = size, .usage = usage, .isBound = VK_FALSE};
+          pointerToTransient->image = getTransientImage (pointerToGraph->logic, pointerToTransient);
+          vkGetImageMemoryRequirements (pointerToGraph->logic, pointerToTransient->image, & pointerToTransient->requirements);
+     }
+     pointerToTransients->images [index].isUsed = VK_TRUE;
+     unsigned int const resource = addGraphResource (pointerToGraph, pointerToTransients->images [index].image, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_NONE);
+     pointerToGraph->resources [resource].transient = index;
+     return resource;
+}
+
+VkImage getGraphImage (struct graph const * const pointerToGraph, unsigned int const resource)
+{
+     return pointerToGraph->resources [resource].image;
+}
+
+unsigned int addGraphPass (struct graph * const pointerToGraph, char const * const name, void (* const record) (VkCommandBuffer, void *), void * const argument, VkBool32 const hasSideEffects)
+{
+     if (pointerToGraph->numberOfPasses == pointerToGraph->capacityOfPasses)
+     {
+          pointerToGraph->capacityOfPasses = pointerToGraph->capacityOfPasses ? 2 * pointerToGraph->capacityOfPasses : 8;
+          pointerToGraph->passes = xrealloc (pointerToGraph->passes, pointerToGraph->capacityOfPasses * sizeof (struct graphPass));
+     }
+     pointerToGraph->passes [pointerToGraph->numberOfPasses] = (struct graphPass) {.name = name, .record = record, .argument = argument, .hasSideEffects = hasSideEffects, .isLive = VK_FALSE};
+     return pointerToGraph->numberOfPasses++;
+}
+
+void useResource (struct graph * const pointerToGraph, unsigned int const pass, unsigned int const resource, enum graphAccess const access)
+{
+     if (pointerToGraph->numberOfUsages == pointerToGraph->capacityOfUsages)
+     {
+          pointerToGraph->capacityOfUsages = pointerToGraph->capacityOfUsages ? 2 * pointerToGraph->capacityOfUsages : 16;
+          pointerToGraph->usages = xrealloc (pointerToGraph->usages, pointerToGraph->capacityOfUsages * sizeof (struct graphUsage));
+     }
+     pointerToGraph->usages [pointerToGraph->numberOfUsages++] = (struct graphUsage) {.pass = pass, .resource = resource, .access = access};
+}
+
+void cullGraph (struct graph * const pointerToGraph)
+{
+     for (unsigned int i = 0; i < pointerToGraph->numberOfResources; ++i) pointerToGraph->resources [i].isNeeded = pointerToGraph->resources [i].isExported;
+     for (unsigned int pass = pointerToGraph->numberOfPasses; pass-- > 0; )
+     {
+          struct graphPass * const pointerToPass = & pointerToGraph->passes [pass];
+          pointerToPass->isLive = pointerToPass->hasSideEffects;
+          for (unsigned int i = 0; i < pointerToGraph->numberOfUsages && ! pointerToPass->isLive; ++i)
+               if (pointerToGraph->usages [i].pass == pass && graphAccesses [pointerToGraph->usages [i].access].isWrite && pointerToGraph->resources [pointerToGraph->usages [i].resource].isNeeded)
+                    pointerToPass->isLive = VK_TRUE;
+          if (! pointerToPass->isLive)
+          {
+               logDebug ("Culling render graph pass %s.", pointerToPass->name);
+               continue;
+          }
+          for (unsigned int i = 0; i < pointerToGraph->numberOfUsages; ++i)
+               if (pointerToGraph->usages [i].pass == pass && ! graphAccesses [pointerToGraph->usages [i].access].isWrite) pointerToGraph->resources [pointerToGraph->usages [i].resource].isNeeded = VK_TRUE;
+     }
+}
+
+VkBool32 isOverlapping (VkDeviceSize const firstOffset, VkDeviceSize const firstSize, VkDeviceSize const secondOffset, VkDeviceSize const secondSize)
+{
+     return firstOffset < secondOffset + secondSize && secondOffset < firstOffset + firstSize;
+}
+
+VkBool32 isTransientConflict (struct transientImage const * const pointerToFirst, struct transientImage const * const pointerToSecond)
+{
+     return pointerToFirst->firstPass <= pointerToSecond->lastPass && pointerToSecond->firstPass <= pointerToFirst->lastPass
+          && isOverlapping (pointerToFirst->offset, pointerToFirst->requirements.size, pointerToSecond->offset, pointerToSecond->requirements.size);
+}
+
+VkDeviceSize placeTransients (struct transientImage * const transients, unsigned int const count)
+{
+     VkDeviceSize total = 0;
+     VkBool32 * isPlaced = xcalloc (count, sizeof (VkBool32));
+     for (unsigned int placed = 0; placed < count; ++placed)
+     {
+          unsigned int next = count;
+          for (unsigned int i = 0; i < count; ++i)
+               if (! isPlaced [i] && (next == count || transients [i].requirements.size > transients [next].requirements.size)) next = i;
+          struct transientImage * const pointerToTransient = & transients [next];
+          VkDeviceSize const alignment = pointerToTransient->requirements.alignment;
+          VkDeviceSize offset = 0;
+          for (VkBool32 isMoved = VK_TRUE; isMoved; )
+          {
+               isMoved = VK_FALSE;
+               pointerToTransient->offset = offset;
+               for (unsigned int i = 0; i < count; ++i)
+                    if (isPlaced [i] && isTransientConflict (& transients [i], pointerToTransient))
+                    {
+                         offset = (transients [i].offset + transients [i].requirements.size + alignment - 1) / alignment * alignment;
+                         isMoved = VK_TRUE;
+                         break;
+                    }
+          }
+          isPlaced [next] = VK_TRUE;
+          if (offset + pointerToTransient->requirements.size > total) total = offset + pointerToTransient->requirements.size;
+     }
+     free (isPlaced);
+     return total;
+}
+
+void bindTransients (struct graph * const pointerToGraph)
+{
+     unsigned int const none = ~0u;
+     struct transients * const pointerToTransients = & pointerToGraph->transients [pointerToGraph->slot];
+     struct transientImage * const transients = pointerToTransients->images;
+     for (unsigned int i = 0; i < pointerToTransients->count; ++i)
+     {
+          transients [i].firstPass = none;
+          transients [i].lastPass = 0;
+     }
+     for (unsigned int i = 0; i < pointerToGraph->numberOfUsages; ++i)
+     {
+          struct graphUsage const usage = pointerToGraph->usages [i];
+          unsigned int const transient = pointerToGraph->resources [usage.resource].transient;
+          if (transient == none || ! pointerToGraph->passes [usage.pass].isLive) continue;
+          if (transients [transient].firstPass == none || usage.pass < transients [transient].firstPass) transients [transient].firstPass = usage.pass;
+          if (usage.pass > transients [transient].lastPass) transients [transient].lastPass = usage.pass;
+     }
+     VkBool32 isValid = VK_TRUE;
+     for (unsigned int i = 0; i < pointerToTransients->count && isValid; ++i)
+     {
+          if (transients [i].isUsed && ! transients [i].isBound) isValid = VK_FALSE;
+          for (unsigned int j = 0; j < i && isValid; ++j)
+               if (transients [i].isUsed && transients [j].isUsed && transients [i].firstPass != none && transients [j].firstPass != none)
+                    isValid = ! isTransientConflict (& transients [i], & transients [j]);
+     }
+     if (isValid) return;
+     if (pointerToTransients->allocation.pointerToBlock)
+     {
+          giveAllocation (pointerToGraph->pointerToAllocator, pointerToTransients->allocation);
+          pointerToTransients->allocation.pointerToBlock = NULL;
+     }
+     VkMemoryRequirements requirements = {.size = 0, .alignment = 1, .memoryTypeBits = ~0u};
+     unsigned int * remap = xcalloc (pointerToTransients->count, sizeof (unsigned int));
+     unsigned int kept = 0;
+     VkDeviceSize requested = 0;
+     for (unsigned int i = 0; i < pointerToTransients->count; ++i)
+     {
+          struct transientImage transient = transients [i];
+          if (transient.isBound || ! transient.isUsed)
+          {
+               vkDestroyImage (pointerToGraph->logic, transient.image, NULL);
+               transient.image = VK_NULL_HANDLE;
+               transient.isBound = VK_FALSE;
+          }
+          if (! transient.isUsed) continue;
+          if (transient.firstPass == none) transient.firstPass = transient.lastPass = 0;
+          if (transient.requirements.alignment > requirements.alignment) requirements.alignment = transient.requirements.alignment;
+          requirements.memoryTypeBits &= transient.requirements.memoryTypeBits;
+          requested += transient.requirements.size;
+          remap [i] = kept;
+          transients [kept++] = transient;
+     }
+     pointerToTransients->count = kept;
+     for (unsigned int i = 0; i < pointerToGraph->numberOfResources; ++i)
+          if (pointerToGraph->resources [i].transient != none) pointerToGraph->resources [i].transient = remap [pointerToGraph->resources [i].transient];
+     free (remap);
+     if (! kept) return;
+     requirements.size = placeTransients (transients, kept);
+     try (requirements.memoryTypeBits == 0, "search for memory shared by the transient images");
+     pointerToTransients->allocation = getAllocation (pointerToGraph->pointerToAllocator, requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+     for (unsigned int i = 0; i < kept; ++i)
+     {
+          if (transients [i].image == VK_NULL_HANDLE) transients [i].image = getTransientImage (pointerToGraph->logic, & transients [i]);
+          try (vkBindImageMemory (pointerToGraph->logic, transients [i].image, pointerToTransients->allocation.memory, pointerToTransients->allocation.offset + transients [i].offset), "Binding a transient image");
+          transients [i].isBound = VK_TRUE;
+     }
+     for (unsigned int i = 0; i < pointerToGraph->numberOfResources; ++i)
+          if (pointerToGraph->resources [i].transient != none) pointerToGraph->resources [i].image = transients [pointerToGraph->resources [i].transient].image;
+     pointerToGraph->numberOfPlacements++;
+     logDebug ("Placed %u transient images of slot %u in %llu bytes instead of %llu.", kept, pointerToGraph->slot, (unsigned long long) requirements.size, (unsigned long long) requested);
+}
+
+void prepareTransients (struct graph * const pointerToGraph)
+{
+     struct transientImage const * const transients = pointerToGraph->transients [pointerToGraph->slot].images;
+     for (unsigned int i = 0; i < pointerToGraph->numberOfResources; ++i)
+     {
+          struct graphResource * const pointerToResource = & pointerToGraph->resources [i];
+          if (pointerToResource->transient == ~0u) continue;
+          struct transientImage const * const pointerToTransient = & transients [pointerToResource->transient];
+          for (unsigned int j = 0; j < pointerToGraph->numberOfUsages; ++j)
+          {
+               unsigned int const other = pointerToGraph->resources [pointerToGraph->usages [j].resource].transient;
+               if (other == ~0u || other == pointerToResource->transient || ! isOverlapping (pointerToTransient->offset, pointerToTransient->requirements.size, transients [other].offset, transients [other].requirements.size)) continue;
+               struct graphAccessInfo const info = graphAccesses [pointerToGraph->usages [j].access];
+               pointerToResource->writeStages |= info.stages;
+               if (info.isWrite) pointerToResource->writeAccess |= info.access;
+          }
+     }
+}
+
+void addBarrier (struct graph * const pointerToGraph, unsigned int const resource, enum graphAccess const access)
+{
+     struct graphAccessInfo const info = graphAccesses [access];
+     struct graphResource * const pointerToResource = & pointerToGraph->resources [resource];
+     VkBool32 const isImage = pointerToResource->image != VK_NULL_HANDLE;
+     VkImageLayout const layout = isImage ? info.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+     VkBool32 const isTransition = isImage && layout != pointerToResource->layout;
+     VkBool32 const isWritten = pointerToResource->writeStages != VK_PIPELINE_STAGE_2_NONE || pointerToResource->writeAccess != VK_ACCESS_2_NONE;
+     VkBool32 isNeeded = isTransition;
+     if (info.isWrite) isNeeded = isNeeded || isWritten || pointerToResource->readStages != VK_PIPELINE_STAGE_2_NONE;
+     else isNeeded = isNeeded || (isWritten && (info.stages & ~pointerToResource->readStages));
+     if (isNeeded)
+     {
+          VkPipelineStageFlags2 const sourceStages = pointerToResource->writeStages | pointerToResource->readStages;
+          if (isImage)
+               pointerToGraph->imageBarriers [pointerToGraph->numberOfImageBarriers++] = (VkImageMemoryBarrier2)
+                    {.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                     .pNext = NULL,
+                     .srcStageMask = sourceStages,
+                     .srcAccessMask = pointerToResource->writeAccess,
+                     .dstStageMask = info.stages,
+                     .dstAccessMask = info.access,
+                     .oldLayout = pointerToResource->layout,
+                     .newLayout = layout,
+                     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                     .image = pointerToResource->image,
+                     .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1},
+                    };
+          else
+               pointerToGraph->bufferBarriers [pointerToGraph->numberOfBufferBarriers++] = (VkBufferMemoryBarrier2)
+                    {.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                     .pNext = NULL,
+                     .srcStageMask = sourceStages,
+                     .srcAccessMask = pointerToResource->writeAccess,
+                     .dstStageMask = info.stages,
+                     .dstAccessMask = info.access,
+                     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                     .buffer = pointerToResource->buffer,
+                     .offset = 0,
+                     .size = VK_WHOLE_SIZE,
+                    };
+     }
+     if (info.isWrite)
+     {
+          pointerToResource->writeStages = info.stages;
+          pointerToResource->writeAccess = info.access;
+          pointerToResource->readStages = VK_PIPELINE_STAGE_2_NONE;
+     }
+     else pointerToResource->readStages |= info.stages;
+     pointerToResource->layout = layout;
+}
+
+void flushBarriers (struct graph * const pointerToGraph, VkCommandBuffer const buffer)
+{
+     unsigned int const numberOfImages = pointerToGraph->numberOfImageBarriers, numberOfBuffers = pointerToGraph->numberOfBufferBarriers;
+     if (numberOfImages + numberOfBuffers == 0) return;
+     if (pointerToGraph->cmdPipelineBarrier2)
+     {
+          VkDependencyInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .pNext = NULL,
+                .dependencyFlags = 0,
+                .memoryBarrierCount = 0,
+                .pMemoryBarriers = NULL,
+                .bufferMemoryBarrierCount = numberOfBuffers,
+                .pBufferMemoryBarriers = pointerToGraph->bufferBarriers,
+                .imageMemoryBarrierCount = numberOfImages,
+                .pImageMemoryBarriers = pointerToGraph->imageBarriers,
+               };
+          pointerToGraph->cmdPipelineBarrier2 (buffer, & info);
+     }
+     else
+     {
+          VkPipelineStageFlags sourceStages = 0, destinationStages = 0;
+          for (unsigned int i = 0; i < numberOfImages; ++i)
+          {
+               VkImageMemoryBarrier2 const barrier = pointerToGraph->imageBarriers [i];
+               sourceStages |= (VkPipelineStageFlags) barrier.srcStageMask;
+               destinationStages |= (VkPipelineStageFlags) barrier.dstStageMask;
+               pointerToGraph->legacyImageBarriers [i] = (VkImageMemoryBarrier)
+                    {.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                     .pNext = NULL,
+                     .srcAccessMask = (VkAccessFlags) barrier.srcAccessMask,
+                     .dstAccessMask = (VkAccessFlags) barrier.dstAccessMask,
+                     .oldLayout = barrier.oldLayout,
+                     .newLayout = barrier.newLayout,
+                     .srcQueueFamilyIndex = barrier.srcQueueFamilyIndex,
+                     .dstQueueFamilyIndex = barrier.dstQueueFamilyIndex,
+                     .image = barrier.image,
+                     .subresourceRange = barrier.subresourceRange,
+                    };
+          }
+          for (unsigned int i = 0; i < numberOfBuffers; ++i)
+          {
+               VkBufferMemoryBarrier2 const barrier = pointerToGraph->bufferBarriers [i];
+               sourceStages |= (VkPipelineStageFlags) barrier.srcStageMask;
+               destinationStages |= (VkPipelineStageFlags) barrier.dstStageMask;
+               pointerToGraph->legacyBufferBarriers [i] = (VkBufferMemoryBarrier)
+                    {.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                     .pNext = NULL,
+                     .srcAccessMask = (VkAccessFlags) barrier.srcAccessMask,
+                     .dstAccessMask = (VkAccessFlags) barrier.dstAccessMask,
+                     .srcQueueFamilyIndex = barrier.srcQueueFamilyIndex,
+                     .dstQueueFamilyIndex = barrier.dstQueueFamilyIndex,
+                     .buffer = barrier.buffer,
+                     .offset = barrier.offset,
+                     .size = barrier.size,
+                    };
+          }
+          vkCmdPipelineBarrier (buffer, sourceStages ? sourceStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, destinationStages ? destinationStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                                0, NULL, numberOfBuffers, pointerToGraph->legacyBufferBarriers, numberOfImages, pointerToGraph->legacyImageBarriers);
+     }
+     pointerToGraph->barriersInTotal += numberOfImages + numberOfBuffers;
+     pointerToGraph->batchesInTotal++;
+     pointerToGraph->numberOfImageBarriers = 0;
+     pointerToGraph->numberOfBufferBarriers = 0;
+}
+
+void executeGraph (struct graph * const pointerToGraph, VkCommandBuffer const buffer)
+{
+     unsigned int const capacity = pointerToGraph->numberOfUsages > pointerToGraph->numberOfResources ? pointerToGraph->numberOfUsages : pointerToGraph->numberOfResources;
+     if (capacity > pointerToGraph->capacityOfBarriers)
+     {
+          pointerToGraph->capacityOfBarriers = capacity;
+          pointerToGraph->imageBarriers = xrealloc (pointerToGraph->imageBarriers, capacity * sizeof (VkImageMemoryBarrier2));
+          pointerToGraph->bufferBarriers = xrealloc (pointerToGraph->bufferBarriers, capacity * sizeof (VkBufferMemoryBarrier2));
+          pointerToGraph->legacyImageBarriers = xrealloc (pointerToGraph->legacyImageBarriers, capacity * sizeof (VkImageMemoryBarrier));
+          pointerToGraph->legacyBufferBarriers = xrealloc (pointerToGraph->legacyBufferBarriers, capacity * sizeof (VkBufferMemoryBarrier));
+     }
+     cullGraph (pointerToGraph);
+     bindTransients (pointerToGraph);
+     prepareTransients (pointerToGraph);
+     for (unsigned int pass = 0; pass < pointerToGraph->numberOfPasses; ++pass)
+     {
+          struct graphPass const * const pointerToPass = & pointerToGraph->passes [pass];
+          if (! pointerToPass->isLive)
+          {
+               pointerToGraph->culledInTotal++;
+               continue;
+          }
+          for (unsigned int i = 0; i < pointerToGraph->numberOfUsages; ++i)
+               if (pointerToGraph->usages [i].pass == pass) addBarrier (pointerToGraph, pointerToGraph->usages [i].resource, pointerToGraph->usages [i].access);
+          flushBarriers (pointerToGraph, buffer);
+          pointerToPass->record (buffer, pointerToPass->argument);
+          pointerToGraph->passesInTotal++;
+     }
+     for (unsigned int i = 0; i < pointerToGraph->numberOfResources; ++i)
+          if (pointerToGraph->resources [i].isExported) addBarrier (pointerToGraph, i, pointerToGraph->resources [i].finalAccess);
+     flushBarriers (pointerToGraph, buffer);
+     pointerToGraph->numberOfExecutions++;
+}
+
+void leaveGraph (struct graph * const pointerToGraph)
+{
+     if (pointerToGraph->numberOfExecutions)
+          logInfo ("Render graph: %.2f passes, %.2f culled, %.2f barriers in %.2f batches per frame, %u transient placements", (double) pointerToGraph->passesInTotal / pointerToGraph->numberOfExecutions,
+                   (double) pointerToGraph->culledInTotal / pointerToGraph->numberOfExecutions, (double) pointerToGraph->barriersInTotal / pointerToGraph->numberOfExecutions,
+                   (double) pointerToGraph->batchesInTotal / pointerToGraph->numberOfExecutions, pointerToGraph->numberOfPlacements);
+     for (unsigned int slot = 0; slot < pointerToGraph->numberOfSlots; ++slot)
+     {
+          struct transients * const pointerToTransients = & pointerToGraph->transients [slot];
+          for (unsigned int i = 0; i < pointerToTransients->count; ++i) vkDestroyImage (pointerToGraph->logic, pointerToTransients->images [i].image, NULL);
+          if (pointerToTransients->allocation.pointerToBlock) giveAllocation (pointerToGraph->pointerToAllocator, pointerToTransients->allocation);
+          free (pointerToTransients->images);
+     }
+     free (pointerToGraph->transients);
+     free (pointerToGraph->resources);
+     free (pointerToGraph->passes);
+     free (pointerToGraph->usages);
+     free (pointerToGraph->imageBarriers);
+     free (pointerToGraph->bufferBarriers);
+     free (pointerToGraph->legacyImageBarriers);
+     free (pointerToGraph->legacyBufferBarriers);
+     free (pointerToGraph);
+}
+
+VkBool32 isMemoryTypeAvailable (VkPhysicalDevice const card, VkMemoryPropertyFlags const flags)
+{
+     VkPhysicalDeviceMemoryProperties properties;
+     vkGetPhysicalDeviceMemoryProperties (card, & properties);
+     for (unsigned int i = 0; i < properties.memoryTypeCount; ++i)
+          if ((properties.memoryTypes [i].propertyFlags & flags) == flags) return VK_TRUE;
+     return VK_FALSE;
+}
+
+VkBool32 isCaptureFormatSupported (VkFormat const format)
+{
+     return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+void growCaptureStream (struct capture * const pointerToCapture, size_t const size)
+{
+     size_t capacity = pointerToCapture->streamCapacity ? pointerToCapture->streamCapacity : (size_t) 64 << 20;
+     while (capacity < size) capacity *= 2;
+     if (pointerToCapture->stream) munmap (pointerToCapture->stream, pointerToCapture->streamCapacity);
+     try (ftruncate (pointerToCapture->streamFile, capacity), "Growing the capture stream");
+     pointerToCapture->stream = mmap (NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, pointerToCapture->streamFile, 0);
+     try (pointerToCapture->stream == MAP_FAILED, "Mapping the capture stream");
+     pointerToCapture->streamCapacity = capacity;
+}
+
+void writeReadback (struct capture * const pointerToCapture, struct readback const * const pointerToReadback)
+{
+     unsigned int const width = pointerToReadback->size.x, height = pointerToReadback->size.y;
+     size_t const size = (size_t) width * height * 4;
+     unsigned char const * const pixels = pointerToReadback->allocation.pointer;
+     if (! (pointerToCapture->memoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+     {
+          VkMappedMemoryRange const range =
+               {.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                .pNext = NULL,
+                .memory = pointerToReadback->allocation.memory,
+                .offset = pointerToReadback->allocation.offset,
+                .size = pointerToReadback->allocation.size,
+               };
+          try (vkInvalidateMappedMemoryRanges (pointerToCapture->logic, 1, & range), "Invalidating a readback buffer");
+     }
+     if (pointerToCapture->captureFormat == CAPTURE_STREAM)
+     {
+          struct captureHeader const header = {.magic = {'F', 'R', 'M', '0'}, .frame = pointerToReadback->frame, .width = width, .height = height, .format = pointerToCapture->format, .size = size};
+          if (pointerToCapture->streamSize + sizeof (header) + size > pointerToCapture->streamCapacity) growCaptureStream (pointerToCapture, pointerToCapture->streamSize + sizeof (header) + size);
+          memcpy (pointerToCapture->stream + pointerToCapture->streamSize, & header, sizeof (header));
+          memcpy (pointerToCapture->stream + pointerToCapture->streamSize + sizeof (header), pixels, size);
+          pointerToCapture->streamSize += sizeof (header) + size;
+          return;
+     }
+     char path [512];
+     snprintf (path, sizeof (path), "%s/frame-%06u.%s", pointerToCapture->directory, pointerToReadback->frame, captureFormatNames [pointerToCapture->captureFormat]);
+     FILE * const file = fopen (path, "wb");
+     if (! file)
+     {
+          logWarning ("Cannot write %s: %s.", path, strerror (errno));
+          return;
+     }
+     if (pointerToCapture->captureFormat == CAPTURE_PPM)
+     {
+          VkBool32 const isBlueFirst = pointerToCapture->format == VK_FORMAT_B8G8R8A8_UNORM || pointerToCapture->format == VK_FORMAT_B8G8R8A8_SRGB;
+          unsigned char * const row = xmalloc0 (3 * width);
+          fprintf (file, "P6\n%u %u\n255\n", width, height);
+          for (unsigned int y = 0; y < height; ++y)
+          {
+               unsigned char const * const source = pixels + (size_t) y * width * 4;
+               for (unsigned int x = 0; x < width; ++x)
+               {
+                    row [3 * x] = source [4 * x + (isBlueFirst ? 2 : 0)];
+                    row [3 * x + 1] = source [4 * x + 1];
+                    row [3 * x + 2] = source [4 * x + (isBlueFirst ? 0 : 2)];
+               }
+               fwrite (row, 3, width, file);
+          }
+          free (row);
+     }
+     else fwrite (pixels, 1, size, file);
+     if (fclose (file)) logWarning ("Cannot finish %s: %s.", path, strerror (errno));
+}
+
+void * runCapture (void * const pointerToArgument)
+{
+     struct capture * const pointerToCapture = pointerToArgument;
+     pthread_mutex_lock (& pointerToCapture->mutex);
+     while (1)
+     {
+          while (pointerToCapture->isRunning && pointerToCapture->head == pointerToCapture->tail) pthread_cond_wait (& pointerToCapture->queued, & pointerToCapture->mutex);
+          if (pointerToCapture->head == pointerToCapture->tail) break;
+          unsigned int const index = pointerToCapture->queue [pointerToCapture->tail++ % pointerToCapture->count];
+          pthread_mutex_unlock (& pointerToCapture->mutex);
+          double const start = getTime ( );
+          writeReadback (pointerToCapture, & pointerToCapture->readbacks [index]);
+          double const duration = getTime ( ) - start;
+          pthread_mutex_lock (& pointerToCapture->mutex);
+          pointerToCapture->writeTime += duration;
+          pointerToCapture->numberOfWrites++;
+          pointerToCapture->readbacks [index].state = READBACK_FREE;
+     }
+     pthread_mutex_unlock (& pointerToCapture->mutex);
+     return NULL;
+}
+
+struct capture * getPointerToCapture (VkPhysicalDevice const card, VkDevice const logic, struct allocator * const pointerToAllocator, VkFormat const format, unsigned int const numberOfSlots, struct options const options)
+{
+     if (! isCaptureFormatSupported (format))
+     {
+          logWarning ("Capture does not handle image format %u.", format);
+          return NULL;
+     }
+     struct capture * pointerToCapture = xmalloc0 (sizeof (struct capture));
+     pointerToCapture->logic = logic;
+     pointerToCapture->pointerToAllocator = pointerToAllocator;
+     pointerToCapture->memoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+     if (! isMemoryTypeAvailable (card, pointerToCapture->memoryFlags)) pointerToCapture->memoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+     pointerToCapture->format = format;
+     pointerToCapture->captureFormat = options.captureFormat;
+     pointerToCapture->directory = options.captureDirectory;
+     pointerToCapture->interval = options.captureInterval;
+     pointerToCapture->count = options.numberOfCaptureBuffers ? options.numberOfCaptureBuffers : numberOfSlots + 2;
+     pointerToCapture->readbacks = xcalloc (pointerToCapture->count, sizeof (struct readback));
+     pointerToCapture->queue = xcalloc (pointerToCapture->count, sizeof (unsigned int));
+     pointerToCapture->numberOfSlots = numberOfSlots;
+     pointerToCapture->pending = xcalloc (numberOfSlots, sizeof (unsigned int));
+     for (unsigned int i = 0; i < numberOfSlots; ++i) pointerToCapture->pending [i] = pointerToCapture->count;
+     pointerToCapture->streamFile = -1;
+     if (pointerToCapture->captureFormat == CAPTURE_STREAM)
+     {
+          char path [512];
+          snprintf (path, sizeof (path), "%s/capture.stream", pointerToCapture->directory);
+          pointerToCapture->streamFile = open (path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+          try (pointerToCapture->streamFile < 0, "Opening the capture stream");
+     }
+     pointerToCapture->isRunning = 1;
+     pthread_mutex_init (& pointerToCapture->mutex, NULL);
+     pthread_cond_init (& pointerToCapture->queued, NULL);
+     try (pthread_create (& pointerToCapture->thread, NULL, runCapture, pointerToCapture), "Starting the capture thread");
+     logInfo ("Capture: every %u frames as %s into %s with %u readback buffers", pointerToCapture->interval, captureFormatNames [pointerToCapture->captureFormat], pointerToCapture->directory, pointerToCapture->count);
+     return pointerToCapture;
+}
+
+void collectCapture (struct capture * const pointerToCapture, unsigned int const slot)
+{
+     unsigned int const index = pointerToCapture->pending [slot];
+     if (index == pointerToCapture->count) return;
+     pointerToCapture->pending [slot] = pointerToCapture->count;
+     pthread_mutex_lock (& pointerToCapture->mutex);
+     pointerToCapture->readbacks [index].state = READBACK_QUEUED;
+     pointerToCapture->queue [pointerToCapture->head++ % pointerToCapture->count] = index;
+     pthread_cond_signal (& pointerToCapture->queued);
+     pthread_mutex_unlock (& pointerToCapture->mutex);
+}
+
+void recordReadback (VkCommandBuffer const buffer, void * const argument)
+{
+     struct readback const * const pointerToReadback = argument;
+     VkBufferImageCopy const region =
+          {.bufferOffset = 0,
+           .bufferRowLength = 0,
+           .bufferImageHeight = 0,
+           .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1},
+           .imageOffset = {.x = 0, .y = 0, .z = 0},
+           .imageExtent = {.width = pointerToReadback->size.x, .height = pointerToReadback->size.y, .depth = 1},
+          };
+     vkCmdCopyImageToBuffer (buffer, pointerToReadback->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pointerToReadback->buffer, 1, & region);
+}
+
+void captureImage (struct capture * const pointerToCapture, struct graph * const pointerToGraph, unsigned int const source, unsigned int const slot, unsigned int const frame, struct point const size)
+{
+     if (frame % pointerToCapture->interval) return;
+     unsigned int index = pointerToCapture->count;
+     pthread_mutex_lock (& pointerToCapture->mutex);
+     for (unsigned int i = 0; i < pointerToCapture->count && index == pointerToCapture->count; ++i)
+          if (pointerToCapture->readbacks [i].state == READBACK_FREE) index = i;
+     if (index < pointerToCapture->count) pointerToCapture->readbacks [index].state = READBACK_RECORDED;
+     pthread_mutex_unlock (& pointerToCapture->mutex);
+     if (index == pointerToCapture->count)
+     {
+          pointerToCapture->numberOfDrops++;
+          logDebug ("Dropping the capture of frame %u, the writer is behind.", frame);
+          return;
+     }
+     struct readback * const pointerToReadback = & pointerToCapture->readbacks [index];
+     VkDeviceSize const bytes = (VkDeviceSize) size.x * size.y * 4;
+     if (pointerToReadback->capacity < bytes)
+     {
+          if (pointerToReadback->capacity)
+          {
+               vkDestroyBuffer (pointerToCapture->logic, pointerToReadback->buffer, NULL);
+               giveAllocation (pointerToCapture->pointerToAllocator, pointerToReadback->allocation);
+          }
+          pointerToReadback->buffer = getDataBuffer (pointerToCapture->logic, pointerToCapture->pointerToAllocator, bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT, pointerToCapture->memoryFlags, & pointerToReadback->allocation);
+          nameObject (pointerToCapture->logic, VK_OBJECT_TYPE_BUFFER, pointerToReadback->buffer, "readback buffer");
+          pointerToReadback->capacity = bytes;
+     }
+     pointerToReadback->frame = frame;
+     pointerToReadback->size = size;
+     pointerToReadback->image = getGraphImage (pointerToGraph, source);
+     unsigned int const destination = importBuffer (pointerToGraph, pointerToReadback->buffer);
+     exportResource (pointerToGraph, destination, GRAPH_HOST_READ);
+     unsigned int const pass = addGraphPass (pointerToGraph, "capture", recordReadback, pointerToReadback, VK_FALSE);
+     useResource (pointerToGraph, pass, source, GRAPH_TRANSFER_SOURCE);
+     useResource (pointerToGraph, pass, destination, GRAPH_TRANSFER_DESTINATION);
+     pointerToCapture->pending [slot] = index;
+     pointerToCapture->numberOfCaptures++;
+}
+
+void leaveCapture (struct capture * const pointerToCapture)
+{
+     for (unsigned int i = 0; i < pointerToCapture->numberOfSlots; ++i) collectCapture (pointerToCapture, i);
+     pthread_mutex_lock (& pointerToCapture->mutex);
+     pointerToCapture->isRunning = 0;
+     pthread_cond_signal (& pointerToCapture->queued);
+     pthread_mutex_unlock (& pointerToCapture->mutex);
+     pthread_join (pointerToCapture->thread, NULL);
+     logInfo ("Capture: %u frames captured, %u written at %.3f ms each, %u dropped", pointerToCapture->numberOfCaptures, pointerToCapture->numberOfWrites,
+              pointerToCapture->numberOfWrites ? 1e3 * pointerToCapture->writeTime / pointerToCapture->numberOfWrites : 0, pointerToCapture->numberOfDrops);
+     if (pointerToCapture->streamFile >= 0)
+     {
+          if (pointerToCapture->stream) munmap (pointerToCapture->stream, pointerToCapture->streamCapacity);
+          if (ftruncate (pointerToCapture->streamFile, pointerToCapture->streamSize)) logWarning ("Cannot trim the capture stream: %s.", strerror (errno));
+          close (pointerToCapture->streamFile);
+     }
+     for (unsigned int i = 0; i < pointerToCapture->count; ++i)
+          if (pointerToCapture->readbacks [i].capacity)
+          {
+               vkDestroyBuffer (pointerToCapture->logic, pointerToCapture->readbacks [i].buffer, NULL);
+               giveAllocation (pointerToCapture->pointerToAllocator, pointerToCapture->readbacks [i].allocation);
+          }
+     pthread_mutex_destroy (& pointerToCapture->mutex);
+     pthread_cond_destroy (& pointerToCapture->queued);
+     free (pointerToCapture->readbacks);
+     free (pointerToCapture->queue);
+     free (pointerToCapture->pending);
+     free (pointerToCapture);
+}
+
+VkBool32 isOverlayFormat (VkFormat const format)
+{
+     return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+struct overlay * getPointerToOverlay (struct arena * const pointerToArena, VkFormat const format, unsigned int const numberOfOutputs)
+{
+     struct overlay * pointerToOverlay = xmalloc0 (sizeof (struct overlay));
+     pointerToOverlay->format = format;
+     pointerToOverlay->isSwapped = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+     pointerToOverlay->pointerToArena = pointerToArena;
+     pointerToOverlay->copies = xcalloc (numberOfOutputs, sizeof (struct overlayCopy));
+     pointerToOverlay->last = getTime ( );
+     logInfo ("Overlay: %ux%u frame time graph uploaded through the staging ring and composed from a transient image every frame", OVERLAY_WIDTH, OVERLAY_HEIGHT);
+     return pointerToOverlay;
+}
+
+uint32_t getOverlayPixel (VkBool32 const isSwapped, unsigned char const red, unsigned char const green, unsigned char const blue)
+{
+     unsigned char const bytes [4] = {isSwapped ? blue : red, green, isSwapped ? red : blue, 255};
+     uint32_t pixel;
+     memcpy (& pixel, bytes, sizeof (pixel));
+     return pixel;
+}
+
+VkBool32 streamOverlay (struct overlay * const pointerToOverlay, struct staging * const pointerToStaging, unsigned int const slot)
+{
+     double const now = getTime ( );
+     pointerToOverlay->intervals [pointerToOverlay->numberOfIntervals++ % OVERLAY_WIDTH] = (float) (now - pointerToOverlay->last);
+     pointerToOverlay->last = now;
+     VkDeviceSize offset;
+     if (! takeFromArena (pointerToOverlay->pointerToArena, slot, OVERLAY_BYTES, sizeof (uint32_t), & pointerToOverlay->offset)) return VK_FALSE;
+     uint32_t * const pixels = takeStaging (pointerToStaging, OVERLAY_BYTES, sizeof (uint32_t), & offset);
+     if (! pixels) return VK_FALSE;
+     VkBool32 const isSwapped = pointerToOverlay->isSwapped;
+     uint32_t const background = getOverlayPixel (isSwapped, 16, 16, 16), line = getOverlayPixel (isSwapped, 96, 96, 96);
+     uint32_t const colours [3] = {getOverlayPixel (isSwapped, 64, 200, 64), getOverlayPixel (isSwapped, 220, 200, 64), getOverlayPixel (isSwapped, 220, 64, 64)};
+     unsigned int tops [OVERLAY_WIDTH];
+     uint32_t bars [OVERLAY_WIDTH];
+     for (unsigned int x = 0; x < OVERLAY_WIDTH; ++x)
+     {
+          double const fraction = pointerToOverlay->intervals [(pointerToOverlay->numberOfIntervals + x) % OVERLAY_WIDTH] / OVERLAY_SCALE;
+          tops [x] = fraction >= 1 ? 0 : OVERLAY_HEIGHT - (unsigned int) (fraction * OVERLAY_HEIGHT);
+          bars [x] = colours [fraction <= 0.5 ? 0 : fraction <= 1 ? 1 : 2];
+     }
+     for (unsigned int y = 0; y < OVERLAY_HEIGHT; ++y)
+          for (unsigned int x = 0; x < OVERLAY_WIDTH; ++x) pixels [y * OVERLAY_WIDTH + x] = y >= tops [x] ? bars [x] : y == OVERLAY_HEIGHT / 2 ? line : background;
+     stageBufferCopy (pointerToStaging, offset, pointerToOverlay->pointerToArena->buffer, pointerToOverlay->offset, OVERLAY_BYTES);
+     pointerToOverlay->numberOfUploads++;
+     return VK_TRUE;
+}
+
+void recordOverlay (VkCommandBuffer const buffer, void * const argument)
+{
+     struct overlayCopy const * const pointerToCopy = argument;
+     VkBufferImageCopy const region =
+          {.bufferOffset = pointerToCopy->offset,
+           .bufferRowLength = 0,
+           .bufferImageHeight = 0,
+           .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1},
+           .imageOffset = {.x = 0, .y = 0, .z = 0},
+           .imageExtent = {.width = OVERLAY_WIDTH, .height = OVERLAY_HEIGHT, .depth = 1},
+          };
+     vkCmdCopyBufferToImage (buffer, pointerToCopy->buffer, getGraphImage (pointerToCopy->pointerToGraph, pointerToCopy->hud), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, & region);
+}
+
+void recordComposition (VkCommandBuffer const buffer, void * const argument)
+{
+     struct overlayCopy const * const pointerToCopy = argument;
+     int const width = (int) (OVERLAY_WIDTH * pointerToCopy->scale), height = (int) (OVERLAY_HEIGHT * pointerToCopy->scale);
+     VkImageBlit const region =
+          {.srcSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1},
+           .srcOffsets = {{.x = 0, .y = 0, .z = 0}, {.x = OVERLAY_WIDTH, .y = OVERLAY_HEIGHT, .z = 1}},
+           .dstSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1},
+           .dstOffsets = {{.x = OVERLAY_MARGIN, .y = OVERLAY_MARGIN, .z = 0}, {.x = OVERLAY_MARGIN + width, .y = OVERLAY_MARGIN + height, .z = 1}},
+          };
+     vkCmdBlitImage (buffer, getGraphImage (pointerToCopy->pointerToGraph, pointerToCopy->hud), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pointerToCopy->target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, & region, VK_FILTER_NEAREST);
+}
+
+void drawOverlay (struct overlay * const pointerToOverlay, struct graph * const pointerToGraph, unsigned int const target, unsigned int const output, struct point const size)
+{
+     unsigned int const scale = 1 + (unsigned int) size.y / OVERLAY_REFERENCE_HEIGHT;
+     if (size.x < (int) (scale * OVERLAY_WIDTH + 2 * OVERLAY_MARGIN) || size.y < (int) (scale * OVERLAY_HEIGHT + 2 * OVERLAY_MARGIN)) return;
+     struct overlayCopy * const pointerToCopy = & pointerToOverlay->copies [output];
+     * pointerToCopy = (struct overlayCopy)
+          {.pointerToGraph = pointerToGraph,
+           .buffer = pointerToOverlay->pointerToArena->buffer,
+           .offset = pointerToOverlay->offset,
+           .hud = addTransientImage (pointerToGraph, pointerToOverlay->format, (struct point) {.x = OVERLAY_WIDTH, .y = OVERLAY_HEIGHT}, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT),
+           .target = getGraphImage (pointerToGraph, target),
+           .scale = scale,
+          };
+     unsigned int const source = importBuffer (pointerToGraph, pointerToCopy->buffer);
+     unsigned int const copy = addGraphPass (pointerToGraph, "overlay", recordOverlay, pointerToCopy, VK_FALSE);
+     useResource (pointerToGraph, copy, source, GRAPH_TRANSFER_SOURCE);
+     useResource (pointerToGraph, copy, pointerToCopy->hud, GRAPH_TRANSFER_DESTINATION);
+     unsigned int const composition = addGraphPass (pointerToGraph, "compose", recordComposition, pointerToCopy, VK_FALSE);
+     useResource (pointerToGraph, composition, pointerToCopy->hud, GRAPH_TRANSFER_SOURCE);
+     useResource (pointerToGraph, composition, target, GRAPH_TRANSFER_DESTINATION);
+}
+
+void leaveOverlay (struct overlay * const pointerToOverlay)
+{
+     logDebug ("Overlay uploads: %u", pointerToOverlay->numberOfUploads);
+     free (pointerToOverlay->copies);
+     free (pointerToOverlay);
+}
+
+void recordSlice (struct worker * const pointerToWorker)
+{
+     struct workers const * const pointerToWorkers = pointerToWorker->pointerToWorkers;
+     double const start = getTime ( );
+     unsigned int const slot = pointerToWorkers->slot;
+     VkCommandBuffer const buffer = pointerToWorkers->buffers [slot * pointerToWorkers->count + pointerToWorker->index];
+     try (vkResetCommandPool (pointerToWorkers->logic, pointerToWorker->pools [slot], 0), "Resetting a worker command pool");
+     {
+          VkCommandBufferInheritanceRenderingInfo const rendering =
+               {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+                .pNext = NULL,
+                .flags = 0,
+                .viewMask = 0,
+                .colorAttachmentCount = 1,
+                .pColorAttachmentFormats = & pointerToWorkers->format,
+                .depthAttachmentFormat = VK_FORMAT_UNDEFINED,
+                .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+                .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+               };
+          VkCommandBufferInheritanceInfo const inheritance =
+               {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                .pNext = pointerToWorkers->renderPass == VK_NULL_HANDLE ? & rendering : NULL,
+                .renderPass = pointerToWorkers->renderPass,
+                .subpass = 0,
+                .framebuffer = pointerToWorkers->framebuffer,
+                .occlusionQueryEnable = VK_FALSE,
+                .queryFlags = 0,
+                .pipelineStatistics = 0,
+               };
+          VkCommandBufferBeginInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = NULL,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+                .pInheritanceInfo = & inheritance,
+               };
+          try (vkBeginCommandBuffer (buffer, & info), "Begin secondary buffer");
+     }
+     unsigned int const top = pointerToWorkers->size.y * pointerToWorker->index / pointerToWorkers->count;
+     unsigned int const bottom = pointerToWorkers->size.y * (pointerToWorker->index + 1) / pointerToWorkers->count;
+     if (bottom > top)
+     {
+          VkClearAttachment const attachment = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .colorAttachment = 0, .clearValue = pointerToWorkers->clearValue};
+          VkClearRect const rectangle = {.rect = {.offset = {.x = 0, .y = top}, .extent = {.width = pointerToWorkers->size.x, .height = bottom - top}}, .baseArrayLayer = 0, .layerCount = 1};
+          vkCmdClearAttachments (buffer, 1, & attachment, 1, & rectangle);
+     }
+     try (vkEndCommandBuffer (buffer), "End secondary buffer");
+     pointerToWorker->recordingTime += getTime ( ) - start;
+     pointerToWorker->numberOfRecordings++;
+}
+
+void * runWorker (void * const pointerToArgument)
+{
+     struct worker * const pointerToWorker = pointerToArgument;
+     struct workers * const pointerToWorkers = pointerToWorker->pointerToWorkers;
+     unsigned int generation = 0;
+     pthread_mutex_lock (& pointerToWorkers->mutex);
+     while (1)
+     {
+          while (pointerToWorkers->isRunning && pointerToWorkers->generation == generation) pthread_cond_wait (& pointerToWorkers->started, & pointerToWorkers->mutex);
+          if (! pointerToWorkers->isRunning) break;
+          generation = pointerToWorkers->generation;
+          pthread_mutex_unlock (& pointerToWorkers->mutex);
+          recordSlice (pointerToWorker);
+          pthread_mutex_lock (& pointerToWorkers->mutex);
+          if (! -- pointerToWorkers->remaining) pthread_cond_signal (& pointerToWorkers->finished);
+     }
+     pthread_mutex_unlock (& pointerToWorkers->mutex);
+     return NULL;
+}
+
+struct workers * getPointerToWorkers (VkDevice const logic, unsigned int const queueFamilyIndex, unsigned int const numberOfSlots, unsigned int const count)
+{
+     struct workers * pointerToWorkers = xmalloc0 (sizeof (struct workers));
+     pointerToWorkers->logic = logic;
+     pointerToWorkers->count = count;
+     pointerToWorkers->numberOfSlots = numberOfSlots;
+     pointerToWorkers->workers = xcalloc (count, sizeof (struct worker));
+     pointerToWorkers->buffers = xcalloc (count * numberOfSlots, sizeof (VkCommandBuffer));
+     pointerToWorkers->isRunning = 1;
+     pthread_mutex_init (& pointerToWorkers->mutex, NULL);
+     pthread_cond_init (& pointerToWorkers->started, NULL);
+     pthread_cond_init (& pointerToWorkers->finished, NULL);
+     for (unsigned int i = 0; i < count; ++i)
+     {
+          struct worker * const pointerToWorker = & pointerToWorkers->workers [i];
+          pointerToWorker->pointerToWorkers = pointerToWorkers;
+          pointerToWorker->index = i;
+          pointerToWorker->pools = xcalloc (numberOfSlots, sizeof (VkCommandPool));
+          for (unsigned int slot = 0; slot < numberOfSlots; ++slot)
+          {
+               pointerToWorker->pools [slot] = getPool (logic, queueFamilyIndex, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+               pointerToWorkers->buffers [slot * count + i] = getBuffer (logic, pointerToWorker->pools [slot], VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+               nameObject (logic, VK_OBJECT_TYPE_COMMAND_BUFFER, pointerToWorkers->buffers [slot * count + i], "worker secondary buffer");
+          }
+     }
+     for (unsigned int i = 0; i < count; ++i) try (pthread_create (& pointerToWorkers->workers [i].thread, NULL, runWorker, & pointerToWorkers->workers [i]), "Starting a recording thread");
+     return pointerToWorkers;
+}
+
+void recordSlices (struct workers * const pointerToWorkers, unsigned int const slot, VkRenderPass const renderPass, VkFramebuffer const framebuffer, VkFormat const format, struct point const size, VkClearValue const clearValue)
+{
+     pthread_mutex_lock (& pointerToWorkers->mutex);
+     pointerToWorkers->slot = slot;
+     pointerToWorkers->renderPass = renderPass;
+     pointerToWorkers->framebuffer = framebuffer;
+     pointerToWorkers->format = format;
+     pointerToWorkers->size = size;
+     pointerToWorkers->clearValue = clearValue;
+     pointerToWorkers->remaining = pointerToWorkers->count;
+     pointerToWorkers->generation++;
+     pthread_cond_broadcast (& pointerToWorkers->started);
+     while (pointerToWorkers->remaining) pthread_cond_wait (& pointerToWorkers->finished, & pointerToWorkers->mutex);
+     pthread_mutex_unlock (& pointerToWorkers->mutex);
+}
+
+void recordDynamicDrawing (VkCommandBuffer const buffer, struct drawing const * const pointerToDrawing)
+{
+     struct workers * const pointerToWorkers = pointerToDrawing->pointerToWorkers;
+     VkRenderingAttachmentInfo const attachment =
+          {.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+           .pNext = NULL,
+           .imageView = pointerToDrawing->view,
+           .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+           .resolveMode = VK_RESOLVE_MODE_NONE,
+           .resolveImageView = VK_NULL_HANDLE,
+           .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+           .loadOp = pointerToWorkers ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_CLEAR,
+           .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+           .clearValue = pointerToDrawing->clearValue,
+          };
+     VkRenderingInfo const info =
+          {.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+           .pNext = NULL,
+           .flags = pointerToWorkers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0,
+           .renderArea = (VkRect2D) {.offset.x = 0, .offset.y = 0, .extent.width = pointerToDrawing->size.x, .extent.height = pointerToDrawing->size.y},
+           .layerCount = 1,
+           .viewMask = 0,
+           .colorAttachmentCount = 1,
+           .pColorAttachments = & attachment,
+           .pDepthAttachment = NULL,
+           .pStencilAttachment = NULL,
+          };
+     if (pointerToWorkers)
+     {
+          recordSlices (pointerToWorkers, pointerToDrawing->slot, VK_NULL_HANDLE, VK_NULL_HANDLE, pointerToDrawing->format, pointerToDrawing->size, pointerToDrawing->clearValue);
+          cmdBeginRendering (buffer, & info);
+          vkCmdExecuteCommands (buffer, pointerToWorkers->count, & pointerToWorkers->buffers [pointerToDrawing->slot * pointerToWorkers->count]);
+     }
+     else cmdBeginRendering (buffer, & info);
+     cmdEndRendering (buffer);
+}
+
+void recordDrawing (VkCommandBuffer const buffer, void * const argument)
+{
+     struct drawing const * const pointerToDrawing = argument;
+     if (pointerToDrawing->renderPass == VK_NULL_HANDLE)
+     {
+          recordDynamicDrawing (buffer, pointerToDrawing);
+          return;
+     }
+     VkRenderPassBeginInfo const info =
+          {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+           .pNext = NULL,
+           .renderPass = pointerToDrawing->renderPass,
+           .framebuffer = pointerToDrawing->framebuffer,
+           .renderArea = (VkRect2D) {.offset.x = 0, .offset.y = 0, .extent.width = pointerToDrawing->size.x, .extent.height = pointerToDrawing->size.y},
+           .clearValueCount = 1,
+           .pClearValues = & pointerToDrawing->clearValue,
+          };
+     struct workers * const pointerToWorkers = pointerToDrawing->pointerToWorkers;
+     if (pointerToWorkers)
+     {
+          recordSlices (pointerToWorkers, pointerToDrawing->slot, pointerToDrawing->renderPass, pointerToDrawing->framebuffer, pointerToDrawing->format, pointerToDrawing->size, pointerToDrawing->clearValue);
+          vkCmdBeginRenderPass (buffer, & info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+          vkCmdExecuteCommands (buffer, pointerToWorkers->count, & pointerToWorkers->buffers [pointerToDrawing->slot * pointerToWorkers->count]);
+     }
+     else vkCmdBeginRenderPass (buffer, & info, VK_SUBPASS_CONTENTS_INLINE);
+     vkCmdEndRenderPass (buffer);
+}
+
+void leaveWorkers (struct workers * const pointerToWorkers)
+{
+     pthread_mutex_lock (& pointerToWorkers->mutex);
+     pointerToWorkers->isRunning = 0;
+     pthread_cond_broadcast (& pointerToWorkers->started);
+     pthread_mutex_unlock (& pointerToWorkers->mutex);
+     for (unsigned int i = 0; i < pointerToWorkers->count; ++i)
+     {
+          struct worker * const pointerToWorker = & pointerToWorkers->workers [i];
+          pthread_join (pointerToWorker->thread, NULL);
+          if (pointerToWorker->numberOfRecordings)
+               logInfo ("Worker %u recorded %u slices, %.3f ms each on average", i, pointerToWorker->numberOfRecordings, 1e3 * pointerToWorker->recordingTime / pointerToWorker->numberOfRecordings);
+          for (unsigned int slot = 0; slot < pointerToWorkers->numberOfSlots; ++slot) vkDestroyCommandPool (pointerToWorkers->logic, pointerToWorker->pools [slot], NULL);
+          free (pointerToWorker->pools);
+     }
+     pthread_mutex_destroy (& pointerToWorkers->mutex);
+     pthread_cond_destroy (& pointerToWorkers->started);
+     pthread_cond_destroy (& pointerToWorkers->finished);
+     free (pointerToWorkers->workers);
+     free (pointerToWorkers->buffers);
+     free (pointerToWorkers);
+}
+
+struct timings * getPointerToTimings (VkPhysicalDevice const card, VkDevice const logic, unsigned int const queueFamilyIndex, unsigned int const numberOfSlots, unsigned int const summaryInterval, char const * const path)
+{
+     struct timings * pointerToTimings = xmalloc0 (sizeof (struct timings));
+     pointerToTimings->capacity = 1 << 14;
+     pointerToTimings->origin = pointerToTimings->lastSummary = getTime ( );
+     pointerToTimings->summaryInterval = summaryInterval;
+     pointerToTimings->path = path;
+     pointerToTimings->starts = xcalloc (pointerToTimings->capacity * NUMBER_OF_PHASES, sizeof (double));
+     pointerToTimings->durations = xcalloc (pointerToTimings->capacity * NUMBER_OF_PHASES, sizeof (double));
+     pointerToTimings->numberOfSlots = numberOfSlots;
+     pointerToTimings->pendingFrames = xcalloc (numberOfSlots, sizeof (unsigned int));
+     for (unsigned int i = 0; i < numberOfSlots; ++i) pointerToTimings->pendingFrames [i] = ~(unsigned int)0;
+     pointerToTimings->queryPool = VK_NULL_HANDLE;
+     unsigned int timestampValidBits;
+     {
+          unsigned int numberOfQueueFamilies;
+          vkGetPhysicalDeviceQueueFamilyProperties (card, &numberOfQueueFamilies, NULL);
+          VkQueueFamilyProperties * pointerToQueueFamilies = xcalloc (numberOfQueueFamilies, sizeof (VkQueueFamilyProperties));
+          vkGetPhysicalDeviceQueueFamilyProperties (card, &numberOfQueueFamilies, pointerToQueueFamilies);
+          timestampValidBits = pointerToQueueFamilies [queueFamilyIndex].timestampValidBits;
+          free (pointerToQueueFamilies);
+     }
+     if (timestampValidBits)
+     {
+          VkPhysicalDeviceProperties properties;
+          vkGetPhysicalDeviceProperties (card, & properties);
+          pointerToTimings->timestampPeriod = properties.limits.timestampPeriod;
+          pointerToTimings->timestampMask = timestampValidBits < 64 ? ((uint64_t) 1 << timestampValidBits) - 1 : ~(uint64_t) 0;
+          VkQueryPoolCreateInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                .pNext = NULL,
+                .flags = 0,
+                .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                .queryCount = 2 * numberOfSlots,
+                .pipelineStatistics = 0,
+               };
+          try (vkCreateQueryPool (logic, & info, NULL, & pointerToTimings->queryPool), "Timestamp query pool creation");
+     }
+     else logWarning ("Timestamps are not supported by the queue family, GPU timings are off.");
+     return pointerToTimings;
+}
+
+void beginTimings (struct timings * const pointerToTimings)
+{
+     unsigned int const row = pointerToTimings->count % pointerToTimings->capacity;
+     for (unsigned int phase = 0; phase < NUMBER_OF_PHASES; ++phase)
+     {
+          pointerToTimings->starts [row * NUMBER_OF_PHASES + phase] = 0;
+          pointerToTimings->durations [row * NUMBER_OF_PHASES + phase] = NAN;
+     }
+}
+
+double recordPhase (struct timings * const pointerToTimings, enum phase const phase, double const start)
+{
+     unsigned int const row = pointerToTimings->count % pointerToTimings->capacity;
+     double const now = getTime ( );
+     pointerToTimings->starts [row * NUMBER_OF_PHASES + phase] = start - pointerToTimings->origin;
+     pointerToTimings->durations [row * NUMBER_OF_PHASES + phase] = (now - start) * 1e3;
+     return now;
+}
+
+void beginTimestamps (struct timings * const pointerToTimings, VkCommandBuffer const buffer, unsigned int const slot)
+{
+     if (pointerToTimings->queryPool == VK_NULL_HANDLE) return;
+     vkCmdResetQueryPool (buffer, pointerToTimings->queryPool, 2 * slot, 2);
+     vkCmdWriteTimestamp (buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pointerToTimings->queryPool, 2 * slot);
+}
+
+void writeEndTimestamp (struct timings * const pointerToTimings, VkCommandBuffer const buffer, unsigned int const slot)
+{
+     if (pointerToTimings->queryPool == VK_NULL_HANDLE) return;
+     vkCmdWriteTimestamp (buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pointerToTimings->queryPool, 2 * slot + 1);
+}
+void markTimestamps (struct timings * const pointerToTimings, unsigned int const slot)
+{
+     if (pointerToTimings->queryPool == VK_NULL_HANDLE) return;
+     pointerToTimings->pendingFrames [slot] = pointerToTimings->count;
+}
+void endTimestamps (struct timings * const pointerToTimings, VkCommandBuffer const buffer, unsigned int const slot)
+{
+     writeEndTimestamp (pointerToTimings, buffer, slot);
+     markTimestamps (pointerToTimings, slot);
+}
+
+void readTimestamps (struct timings * const pointerToTimings, VkDevice const logic, unsigned int const slot)
+{
+     unsigned int const frame = pointerToTimings->pendingFrames [slot];
+     if (pointerToTimings->queryPool == VK_NULL_HANDLE || frame == ~(unsigned int)0) return;
+     pointerToTimings->pendingFrames [slot] = ~(unsigned int)0;
+     uint64_t ticks [2];
+     if (vkGetQueryPoolResults (logic, pointerToTimings->queryPool, 2 * slot, 2, sizeof (ticks), ticks, sizeof (ticks [0]), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) return;
+     if (pointerToTimings->count - frame >= pointerToTimings->capacity) return;
+     unsigned int const row = frame % pointerToTimings->capacity;
+     pointerToTimings->starts [row * NUMBER_OF_PHASES + PHASE_GPU] = pointerToTimings->starts [row * NUMBER_OF_PHASES + PHASE_SUBMIT];
+     pointerToTimings->durations [row * NUMBER_OF_PHASES + PHASE_GPU] = ((ticks [1] - ticks [0]) & pointerToTimings->timestampMask) * pointerToTimings->timestampPeriod * 1e-6;
+}
+
+int compareDoubles (void const * const pointerToLeft, void const * const pointerToRight)
+{
+     double const left = * (double const *) pointerToLeft;
+     double const right = * (double const *) pointerToRight;
+     return (left > right) - (left < right);
+}
+
+struct statistics getStatistics (struct timings const * const pointerToTimings, enum phase const phase, unsigned int numberOfFrames)
+{
+     unsigned int const retained = pointerToTimings->count < pointerToTimings->capacity ? pointerToTimings->count : pointerToTimings->capacity;
+     if (numberOfFrames > retained) numberOfFrames = retained;
+     struct statistics statistics = {.count = 0, .minimum = 0, .mean = 0, .median = 0, .percentile99 = 0};
+     double * values = xcalloc (numberOfFrames + 1, sizeof (double));
+     double sum = 0;
+     for (unsigned int frame = pointerToTimings->count - numberOfFrames; frame < pointerToTimings->count; ++frame)
+     {
+          double const value = pointerToTimings->durations [(frame % pointerToTimings->capacity) * NUMBER_OF_PHASES + phase];
+          if (isnan (value)) continue;
+          values [statistics.count++] = value;
+          sum += value;
+     }
+     if (statistics.count)
+     {
+          qsort (values, statistics.count, sizeof (double), compareDoubles);
+          statistics.minimum = values [0];
+          statistics.mean = sum / statistics.count;
+          statistics.median = values [(statistics.count - 1) / 2];
+          statistics.percentile99 = values [(99 * statistics.count + 99) / 100 - 1];
      }
-     return chain;
+     free (values);
+     return statistics;
 }
 
-struct images * getPointerToImages (VkDevice const logic, VkSwapchainKHR const swapchain, VkFormat const format, VkRenderPass const renderPass, struct point const size)
+void printTimings (struct timings const * const pointerToTimings, unsigned int const numberOfFrames, double const seconds)
 {
-     unsigned int count;
-     try (vkGetSwapchainImagesKHR (logic, swapchain, &count, NULL), "Get image count");
-     VkImage * images = xcalloc (count, sizeof (VkImage));
-     try (vkGetSwapchainImagesKHR (logic, swapchain, &count, images), "Get images");
-     VkImageView * views = xcalloc (count, sizeof (VkImageView));
-     VkFramebuffer * frames = xcalloc (count, sizeof (VkFramebuffer));
-     for (unsigned int i = 0; i < count; ++i)
+     char line [NUMBER_OF_PHASES * 48];
+     int length = 0;
+     for (unsigned int phase = 0; phase < NUMBER_OF_PHASES; ++phase)
      {
-          printf ("Initializing image %d.\n", i);
-          {
-               VkComponentMapping components =
-                    {.r = VK_COMPONENT_SWIZZLE_R,
-                     .g = VK_COMPONENT_SWIZZLE_G,
-                     .b = VK_COMPONENT_SWIZZLE_B,
-                     .a = VK_COMPONENT_SWIZZLE_A,
-                    };
-               VkImageSubresourceRange subresourceRange =
-                    {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                     .baseMipLevel = 0,
-                     .levelCount = 1,
-                     .baseArrayLayer = 0,
-                     .layerCount = 1
-                    };
-               VkImageViewCreateInfo info =
-                    {.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-                     .pNext = NULL,
-                     .flags = 0,
-                     .image = images [i],
-                     .viewType = VK_IMAGE_VIEW_TYPE_2D,
-                     .format = format,
-                     .components = components,
-                     .subresourceRange = subresourceRange,
-                    };
-               try (vkCreateImageView (logic, & info, NULL, & views [i]), "Creating image view");
-               printf ("Initializing image view %d at %p.\n", i, & images [i]);
-          }
-          {
-               VkFramebufferCreateInfo info =
-                    {.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-                     .pNext = NULL,
-                     .flags = 0,
-                     .renderPass = renderPass,
-                     .attachmentCount = 1,
-                     .pAttachments = & views [i],
-                     .width = size.x,
-                     .height = size.y,
-                     .layers = 1,
-                    };
-               try (vkCreateFramebuffer (logic, & info, NULL, & frames [i]), "Creating framebuffer");
-               printf ("Initializing framebuffer %d at %p.\n", i, & frames [i]);
-          }
+          struct statistics const statistics = getStatistics (pointerToTimings, phase, numberOfFrames);
+          if (statistics.count) length += snprintf (line + length, sizeof (line) - length, " %s %.3f/%.3f/%.3f/%.3f", phaseNames [phase], statistics.minimum, statistics.mean, statistics.median, statistics.percentile99);
      }
-     struct images * pointerToMemory = xmalloc0 (sizeof (struct images));
-     struct images temporaryStructure = {.count = count, .views = views, .images = images, .frames = frames};
-     memcpy (pointerToMemory, & temporaryStructure, sizeof (temporaryStructure));
-     printf ("pointer to views: %p.", pointerToMemory->views);
-     return pointerToMemory;
+     logInfo ("Timings over %u frames, %.1f fps, %s, min/mean/p50/p99 ms:%s", numberOfFrames, numberOfFrames / seconds, pointerToTimings->configuration, line);
 }
 
-VkCommandPool getPool (VkDevice const logic, unsigned int const queueFamilyIndex)
+void endTimings (struct timings * const pointerToTimings, double const frameStart)
 {
-     VkCommandPool pool;
+     double const now = recordPhase (pointerToTimings, PHASE_FRAME, frameStart);
+     pointerToTimings->count++;
+     if (pointerToTimings->summaryInterval && now - pointerToTimings->lastSummary >= pointerToTimings->summaryInterval)
      {
-          VkCommandPoolCreateInfo const info =
-               {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-                .pNext = NULL,
-                .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-                .queueFamilyIndex = queueFamilyIndex,
-               };
-          try (vkCreateCommandPool (logic, &info, NULL, &pool), "Vulkan command pool acquisition");
+          printTimings (pointerToTimings, pointerToTimings->count - pointerToTimings->lastSummaryCount, now - pointerToTimings->lastSummary);
+          pointerToTimings->lastSummary = now;
+          pointerToTimings->lastSummaryCount = pointerToTimings->count;
      }
-     return pool;
 }
 
-VkCommandBuffer getBuffer (VkDevice const logic, VkCommandPool const pool)
+void dumpTimings (struct timings const * const pointerToTimings, char const * const path)
 {
-     VkCommandBuffer buffer;
+     FILE * file = fopen (path, "w");
+     if (! file)
      {
-          VkCommandBufferAllocateInfo info =
-               {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                .pNext = NULL,
-                .commandPool = pool,
-                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                .commandBufferCount = 1,
-               };
-               try (vkAllocateCommandBuffers (logic, &info, &buffer), "Vulkan command buffer allocation");
+          perror (path);
+          return;
      }
-     return buffer;
+     unsigned int const retained = pointerToTimings->count < pointerToTimings->capacity ? pointerToTimings->count : pointerToTimings->capacity;
+     size_t const length = strlen (path);
+     if (length >= 5 && ! strcmp (path + length - 5, ".json"))
+     {
+          char const * separator = "";
+          fprintf (file, "{\"traceEvents\": [\n");
+          for (unsigned int frame = pointerToTimings->count - retained; frame < pointerToTimings->count; ++frame)
+               for (unsigned int phase = 0; phase < NUMBER_OF_PHASES; ++phase)
+               {
+                    unsigned int const cell = (frame % pointerToTimings->capacity) * NUMBER_OF_PHASES + phase;
+                    if (isnan (pointerToTimings->durations [cell])) continue;
+                    fprintf (file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %u}}",
+                             separator, phaseNames [phase], phase == PHASE_GPU ? 2 : 1, pointerToTimings->starts [cell] * 1e6, pointerToTimings->durations [cell] * 1e3, frame);
+                    separator = ",\n";
+               }
+          fprintf (file, "\n], \"otherData\": {\"configuration\": \"%s\"}}\n", pointerToTimings->configuration);
+     }
+     else
+     {
+          fprintf (file, "frame");
+          for (unsigned int phase = 0; phase < NUMBER_OF_PHASES; ++phase) fprintf (file, ",%s", phaseNames [phase]);
+          fprintf (file, "\n");
+          for (unsigned int frame = pointerToTimings->count - retained; frame < pointerToTimings->count; ++frame)
+          {
+               fprintf (file, "%u", frame);
+               for (unsigned int phase = 0; phase < NUMBER_OF_PHASES; ++phase)
+               {
+                    double const value = pointerToTimings->durations [(frame % pointerToTimings->capacity) * NUMBER_OF_PHASES + phase];
+                    if (isnan (value)) fprintf (file, ",");
+                    else fprintf (file, ",%.6f", value);
+               }
+               fprintf (file, "\n");
+          }
+     }
+     fclose (file);
+     logInfo ("Timings of %u frames written to %s.", retained, path);
+}
+
+void leaveTimings (VkDevice const logic, struct timings * const pointerToTimings)
+{
+     if (pointerToTimings->path) dumpTimings (pointerToTimings, pointerToTimings->path);
+     if (pointerToTimings->queryPool != VK_NULL_HANDLE) vkDestroyQueryPool (logic, pointerToTimings->queryPool, NULL);
+     free (pointerToTimings->starts);
+     free (pointerToTimings->durations);
+     free (pointerToTimings->pendingFrames);
+     free (pointerToTimings);
 }
 
-VkRenderPass getRenderPass (VkDevice const logic, VkFormat const format)
+VkRenderPass getRenderPass (VkDevice const logic, VkFormat const format, VkAttachmentLoadOp const loadOp)
 {
      VkRenderPass renderPass;
      {
@@ -288,16 +3316,16 @@ VkRenderPass getRenderPass (VkDevice const logic, VkFormat const format)
                {.flags = 0,
                 .format = format,
                 .samples = VK_SAMPLE_COUNT_1_BIT,
-                .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                .loadOp = loadOp,
                 .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
                 .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
                 .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                };
           VkAttachmentReference reference =
                {.attachment = 0,
-                .layout = VK_IMAGE_LAYOUT_GENERAL,
+                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                };
           VkSubpassDescription subpass =
                {.flags = 0,
@@ -311,6 +3339,23 @@ VkRenderPass getRenderPass (VkDevice const logic, VkFormat const format)
                 .preserveAttachmentCount = 0,
                 .pPreserveAttachments = NULL,
                };
+          VkSubpassDependency const dependencies [2] =
+               {{.srcSubpass = VK_SUBPASS_EXTERNAL,
+                 .dstSubpass = 0,
+                 .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                 .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                 .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                 .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                 .dependencyFlags = 0,
+                },
+                {.srcSubpass = 0,
+                 .dstSubpass = VK_SUBPASS_EXTERNAL,
+                 .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                 .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                 .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                 .dstAccessMask = 0,
+                 .dependencyFlags = 0,
+                }};
           VkRenderPassCreateInfo info =
                {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
                 .pNext = NULL,
@@ -319,100 +3364,718 @@ VkRenderPass getRenderPass (VkDevice const logic, VkFormat const format)
                 .pAttachments = & attachment,
                 .subpassCount = 1,
                 .pSubpasses = & subpass,
-                .dependencyCount = 0,
-                .pDependencies = NULL,
+                .dependencyCount = 2,
+                .pDependencies = dependencies,
                };
           try (vkCreateRenderPass (logic, & info, NULL, & renderPass), "Create render pass");
      }
+     nameObject (logic, VK_OBJECT_TYPE_RENDER_PASS, renderPass, "main render pass");
      return renderPass;
 }
 
-struct devices enter (const struct point size)
+void markStartup (struct startup * const pointerToStartup, char const * const name)
+{
+     double const now = getTime ( );
+     if (pointerToStartup->count < STARTUP_STEPS)
+     {
+          pointerToStartup->names [pointerToStartup->count] = name;
+          pointerToStartup->durations [pointerToStartup->count++] = now - pointerToStartup->last;
+     }
+     pointerToStartup->last = now;
+}
+
+double printStartup (struct startup const * const pointerToStartup)
+{
+     char line [LOG_MESSAGE_SIZE] = "";
+     size_t length = 0;
+     for (unsigned int i = 0; i < pointerToStartup->count && length < sizeof (line); ++i)
+          length += snprintf (line + length, sizeof (line) - length, " %s %.1f", pointerToStartup->names [i], 1e3 * pointerToStartup->durations [i]);
+     double const total = 1e3 * (pointerToStartup->last - pointerToStartup->origin);
+     logInfo ("Startup in %.1f ms:%s", total, line);
+     return total;
+}
+
+VkBool32 isPipelineCacheValid (VkPhysicalDevice const card, void const * const data, size_t const size)
+{
+     VkPipelineCacheHeaderVersionOne header;
+     if (size < sizeof (header)) return VK_FALSE;
+     memcpy (& header, data, sizeof (header));
+     VkPhysicalDeviceProperties properties;
+     vkGetPhysicalDeviceProperties (card, & properties);
+     return header.headerSize >= sizeof (header) && header.headerSize <= size
+          && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+          && header.vendorID == properties.vendorID && header.deviceID == properties.deviceID
+          && ! memcmp (header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+void * loadPipelines (void * const pointerToArgument)
+{
+     struct pipelines * const pointerToPipelines = pointerToArgument;
+     double const start = getTime ( );
+     void * data = NULL;
+     size_t size = 0;
+     FILE * const file = * pointerToPipelines->path ? fopen (pointerToPipelines->path, "rb") : NULL;
+     if (file)
+     {
+          long length = -1;
+          if (! fseek (file, 0, SEEK_END)) length = ftell (file);
+          rewind (file);
+          if (length > 0)
+          {
+               data = xmalloc0 (length);
+               if (fread (data, 1, length, file) == (size_t) length) size = length;
+          }
+          fclose (file);
+     }
+     if (size && ! isPipelineCacheValid (pointerToPipelines->card, data, size))
+     {
+          logWarning ("Ignoring the pipeline cache %s, its header does not match this device.", pointerToPipelines->path);
+          size = 0;
+     }
+     {
+          VkPipelineCacheCreateInfo const info =
+               {.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                .pNext = NULL,
+                .flags = 0,
+                .initialDataSize = size,
+                .pInitialData = size ? data : NULL,
+               };
+          try (vkCreatePipelineCache (pointerToPipelines->logic, & info, NULL, & pointerToPipelines->cache), "Creating the pipeline cache");
+     }
+     free (data);
+     pointerToPipelines->loadedSize = size;
+     pointerToPipelines->loadTime = getTime ( ) - start;
+     return NULL;
+}
+
+struct pipelines * getPointerToPipelines (VkPhysicalDevice const card, VkDevice const logic, VkBool32 const isEnabled, char const * const directory)
+{
+     struct pipelines * pointerToPipelines = xmalloc0 (sizeof (struct pipelines));
+     pointerToPipelines->card = card;
+     pointerToPipelines->logic = logic;
+     if (isEnabled)
+     {
+          VkPhysicalDeviceProperties properties;
+          vkGetPhysicalDeviceProperties (card, & properties);
+          char key [2 * VK_UUID_SIZE + 1];
+          formatUUID (properties.pipelineCacheUUID, key);
+          snprintf (pointerToPipelines->path, sizeof (pointerToPipelines->path), "%s/pipelines-%s-%08x.cache", directory, key, properties.driverVersion);
+     }
+     try (pthread_create (& pointerToPipelines->thread, NULL, loadPipelines, pointerToPipelines), "Starting the pipeline thread");
+     return pointerToPipelines;
+}
+
+void waitForPipelines (struct pipelines * const pointerToPipelines)
+{
+     pthread_join (pointerToPipelines->thread, NULL);
+     logInfo ("Pipeline cache: %zu bytes from %s in %.1f ms", pointerToPipelines->loadedSize, * pointerToPipelines->path ? pointerToPipelines->path : "nowhere", 1e3 * pointerToPipelines->loadTime);
+}
+
+void leavePipelines (struct pipelines * const pointerToPipelines)
+{
+     size_t size = 0;
+     if (* pointerToPipelines->path && vkGetPipelineCacheData (pointerToPipelines->logic, pointerToPipelines->cache, & size, NULL) == VK_SUCCESS && size && size != pointerToPipelines->loadedSize)
+     {
+          void * const data = xmalloc0 (size);
+          char temporaryPath [sizeof (pointerToPipelines->path) + 4];
+          snprintf (temporaryPath, sizeof (temporaryPath), "%s.tmp", pointerToPipelines->path);
+          FILE * const file = vkGetPipelineCacheData (pointerToPipelines->logic, pointerToPipelines->cache, & size, data) == VK_SUCCESS ? fopen (temporaryPath, "wb") : NULL;
+          if (file && fwrite (data, 1, size, file) == size && ! fclose (file) && ! rename (temporaryPath, pointerToPipelines->path))
+               logInfo ("Pipeline cache: %zu bytes saved to %s", size, pointerToPipelines->path);
+          else logWarning ("Could not save the pipeline cache to %s.", pointerToPipelines->path);
+          free (data);
+     }
+     vkDestroyPipelineCache (pointerToPipelines->logic, pointerToPipelines->cache, NULL);
+     free (pointerToPipelines);
+}
+
+struct replay * getPointerToReplay (VkDevice const logic, struct allocator * const pointerToAllocator, unsigned int const queueFamilyIndex, unsigned int const numberOfSlots)
+{
+     struct replay * pointerToReplay = xmalloc0 (sizeof (struct replay));
+     pointerToReplay->logic = logic;
+     pointerToReplay->numberOfSlots = numberOfSlots;
+     pointerToReplay->pool = getPool (logic, queueFamilyIndex, 0);
+     pointerToReplay->parameters = getDataBuffer (logic, pointerToAllocator, numberOfSlots * sizeof (VkClearColorValue), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, & pointerToReplay->parametersAllocation);
+     nameObject (logic, VK_OBJECT_TYPE_BUFFER, pointerToReplay->parameters, "replayed frame parameters");
+     pointerToReplay->swatches = xcalloc (numberOfSlots, sizeof (VkImage));
+     pointerToReplay->swatchAllocations = xcalloc (numberOfSlots, sizeof (struct allocation));
+     for (unsigned int slot = 0; slot < numberOfSlots; ++slot)
+     {
+          {
+               VkImageCreateInfo const info =
+                    {.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                     .pNext = NULL,
+                     .flags = 0,
+                     .imageType = VK_IMAGE_TYPE_2D,
+                     .format = REPLAY_SWATCH_FORMAT,
+                     .extent = {.width = 1, .height = 1, .depth = 1},
+                     .mipLevels = 1,
+                     .arrayLayers = 1,
+                     .samples = VK_SAMPLE_COUNT_1_BIT,
+                     .tiling = VK_IMAGE_TILING_OPTIMAL,
+                     .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                     .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                     .queueFamilyIndexCount = 0,
+                     .pQueueFamilyIndices = NULL,
+                     .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                    };
+               try (vkCreateImage (logic, & info, NULL, & pointerToReplay->swatches [slot]), "Creating replay swatch");
+               nameObject (logic, VK_OBJECT_TYPE_IMAGE, pointerToReplay->swatches [slot], "replayed colour swatch");
+          }
+          VkMemoryRequirements requirements;
+          vkGetImageMemoryRequirements (logic, pointerToReplay->swatches [slot], & requirements);
+          pointerToReplay->swatchAllocations [slot] = getAllocation (pointerToAllocator, requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+          try (vkBindImageMemory (logic, pointerToReplay->swatches [slot], pointerToReplay->swatchAllocations [slot].memory, pointerToReplay->swatchAllocations [slot].offset), "Binding replay swatch memory");
+     }
+     return pointerToReplay;
+}
+
+void recordReplayParameters (VkCommandBuffer const buffer, void * const argument)
+{
+     struct replayFill const * const pointerToFill = argument;
+     VkBufferImageCopy const region =
+          {.bufferOffset = pointerToFill->offset,
+           .bufferRowLength = 0,
+           .bufferImageHeight = 0,
+           .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1},
+           .imageOffset = {.x = 0, .y = 0, .z = 0},
+           .imageExtent = {.width = 1, .height = 1, .depth = 1},
+          };
+     vkCmdCopyBufferToImage (buffer, pointerToFill->parameters, pointerToFill->swatch, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, & region);
+}
+
+void recordReplayFill (VkCommandBuffer const buffer, void * const argument)
 {
+     struct replayFill const * const pointerToFill = argument;
+     VkImageBlit const region =
+          {.srcSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1},
+           .srcOffsets = {{.x = 0, .y = 0, .z = 0}, {.x = 1, .y = 1, .z = 1}},
+           .dstSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1},
+           .dstOffsets = {{.x = 0, .y = 0, .z = 0}, {.x = pointerToFill->size.x, .y = pointerToFill->size.y, .z = 1}},
+          };
+     vkCmdBlitImage (buffer, pointerToFill->swatch, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pointerToFill->target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, & region, VK_FILTER_NEAREST);
+}
+
+void recordReplay (struct replay * const pointerToReplay, struct devices const devices, struct output const * const pointerToOutput, VkBool32 const isTimed)
+{
+     struct images * const pointerToImages = pointerToOutput->pointerToImages;
+     struct point const size = pointerToOutput->size;
+     if (pointerToReplay->pointerToImages == pointerToImages && pointerToReplay->size.x == size.x && pointerToReplay->size.y == size.y) return;
+     double const start = getTime ( );
+     VkDevice const logic = pointerToReplay->logic;
+     unsigned int const numberOfSlots = pointerToReplay->numberOfSlots;
+     if (pointerToReplay->buffers)
+     {
+          try (vkDeviceWaitIdle (logic), "Waiting for the replayed buffers");
+          vkFreeCommandBuffers (logic, pointerToReplay->pool, pointerToReplay->numberOfBuffers, pointerToReplay->buffers);
+          free (pointerToReplay->buffers);
+     }
+     pointerToReplay->numberOfBuffers = pointerToImages->count * numberOfSlots;
+     pointerToReplay->buffers = xcalloc (pointerToReplay->numberOfBuffers, sizeof (VkCommandBuffer));
+     struct graph * const pointerToGraph = devices.pointerToGraph;
+     for (unsigned int image = 0; image < pointerToImages->count; ++image)
+     {
+          for (unsigned int slot = 0; slot < numberOfSlots; ++slot)
+          {
+               VkCommandBuffer const buffer = pointerToReplay->buffers [image * numberOfSlots + slot] = getBuffer (logic, pointerToReplay->pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+               nameObject (logic, VK_OBJECT_TYPE_COMMAND_BUFFER, buffer, "replayed frame buffer");
+               VkCommandBufferBeginInfo const info =
+                    {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                     .pNext = NULL,
+                     .flags = 0,
+                     .pInheritanceInfo = NULL,
+                    };
+               try (vkBeginCommandBuffer (buffer, & info), "Begin replayed buffer");
+               if (isTimed) beginTimestamps (devices.pointerToTimings, buffer, slot);
+               struct replayFill fill = {.parameters = pointerToReplay->parameters, .offset = slot * sizeof (VkClearColorValue), .swatch = pointerToReplay->swatches [slot], .target = pointerToImages->images [image], .size = size};
+               resetGraph (pointerToGraph, slot);
+               unsigned int const parameters = importBuffer (pointerToGraph, fill.parameters);
+               unsigned int const swatch = importImage (pointerToGraph, fill.swatch, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+               unsigned int const target = importImage (pointerToGraph, fill.target, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+               exportResource (pointerToGraph, target, pointerToOutput->chain != VK_NULL_HANDLE ? GRAPH_PRESENT : GRAPH_TRANSFER_SOURCE);
+               unsigned int const copy = addGraphPass (pointerToGraph, "parameters", recordReplayParameters, & fill, VK_FALSE);
+               useResource (pointerToGraph, copy, parameters, GRAPH_TRANSFER_SOURCE);
+               useResource (pointerToGraph, copy, swatch, GRAPH_TRANSFER_DESTINATION);
+               unsigned int const draw = addGraphPass (pointerToGraph, "fill", recordReplayFill, & fill, VK_FALSE);
+               useResource (pointerToGraph, draw, swatch, GRAPH_TRANSFER_SOURCE);
+               useResource (pointerToGraph, draw, target, GRAPH_TRANSFER_DESTINATION);
+               executeGraph (pointerToGraph, buffer);
+               if (isTimed) writeEndTimestamp (devices.pointerToTimings, buffer, slot);
+               try (vkEndCommandBuffer (buffer), "End replayed buffer");
+          }
+     }
+     pointerToReplay->pointerToImages = pointerToImages;
+     pointerToReplay->size = size;
+     pointerToReplay->numberOfRecordings++;
+     pointerToReplay->recordingTime += getTime ( ) - start;
+     logInfo ("Replay: %u buffers recorded for %u images in %.3f ms", pointerToReplay->numberOfBuffers, pointerToImages->count, 1e3 * (getTime ( ) - start));
+}
+
+VkCommandBuffer takeReplay (struct replay * const pointerToReplay, unsigned int const imageIndex, unsigned int const slot, VkClearValue const clearValue)
+{
+     memcpy ((char *) pointerToReplay->parametersAllocation.pointer + slot * sizeof (VkClearColorValue), & clearValue.color, sizeof (VkClearColorValue));
+     return pointerToReplay->buffers [imageIndex * pointerToReplay->numberOfSlots + slot];
+}
+
+void leaveReplay (struct allocator * const pointerToAllocator, struct replay * const pointerToReplay)
+{
+     vkDestroyCommandPool (pointerToReplay->logic, pointerToReplay->pool, NULL);
+     vkDestroyBuffer (pointerToReplay->logic, pointerToReplay->parameters, NULL);
+     giveAllocation (pointerToAllocator, pointerToReplay->parametersAllocation);
+     for (unsigned int slot = 0; slot < pointerToReplay->numberOfSlots; ++slot)
+     {
+          vkDestroyImage (pointerToReplay->logic, pointerToReplay->swatches [slot], NULL);
+          giveAllocation (pointerToAllocator, pointerToReplay->swatchAllocations [slot]);
+     }
+     if (pointerToReplay->numberOfRecordings) logInfo ("Replay: recorded %u times, %.3f ms each", pointerToReplay->numberOfRecordings, 1e3 * pointerToReplay->recordingTime / pointerToReplay->numberOfRecordings);
+     free (pointerToReplay->swatches);
+     free (pointerToReplay->swatchAllocations);
+     free (pointerToReplay->buffers);
+     free (pointerToReplay);
+}
+
+void describeSwapchain (struct devices const devices, char * const buffer, size_t const size)
+{
+     unsigned int const numberOfWorkers = devices.pointerToWorkers ? devices.pointerToWorkers->count : 0;
+     struct output const * const pointerToOutput = & devices.outputs [0];
+     char const * const replayed = pointerToOutput->pointerToReplay ? ", replayed" : "";
+     char outputs [24] = "";
+     if (devices.numberOfOutputs > 1) snprintf (outputs, sizeof (outputs), "%u outputs, ", devices.numberOfOutputs);
+     if (pointerToOutput->chain == VK_NULL_HANDLE) snprintf (buffer, size, "headless, %s%u images, %u frames in flight, %u workers%s", outputs, pointerToOutput->pointerToImages->count, devices.pointerToFrames->count, numberOfWorkers, replayed);
+     else snprintf (buffer, size, "%s by %s policy, %s%u images, %u frames in flight, %u workers%s", getPresentModeName (pointerToOutput->presentMode), presentPolicyNames [devices.presentPolicy], outputs, pointerToOutput->pointerToImages->count, devices.pointerToFrames->count, numberOfWorkers, replayed);
+}
+
+struct devices enter (struct options const options)
+{
+     struct point const size = options.size;
      struct devices devices;
-     if (! glfwInit ( )) exit (-1);
-     glfwWindowHint (GLFW_CLIENT_API, GLFW_NO_API);
-     glfwWindowHint (GLFW_RESIZABLE, GLFW_FALSE);
-     devices.window = glfwCreateWindow (size.x, size.y, "Hello World", NULL, NULL);
-     if (! devices.window)
+     struct startup startup = {.count = 0, .origin = getTime ( )};
+     startup.last = startup.origin;
+     startLogging ( );
+     devices.numberOfOutputs = options.numberOfOutputs ? options.numberOfOutputs : 1;
+     devices.outputs = xcalloc (devices.numberOfOutputs, sizeof (struct output));
+     for (unsigned int i = 0; i < devices.numberOfOutputs; ++i)
+          devices.outputs [i] = (struct output) {.window = NULL, .surface = VK_NULL_HANDLE, .chain = VK_NULL_HANDLE, .size = size, .presentMode = VK_PRESENT_MODE_MAX_ENUM_KHR, .pointerToRetirements = xmalloc0 (sizeof (struct retirements)), .isStale = 0};
+     devices.requestedImageCount = options.imageCount;
+     devices.presentPolicy = options.presentPolicy;
+     devices.requestedPresentMode = options.presentMode;
+     devices.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+     VkBool32 const isPresenting = ! options.isHeadless;
+     if (isPresenting)
      {
-          glfwTerminate ( );
-          exit (-1);
+          if (! glfwInit ( )) exit (-1);
+          markStartup (& startup, "glfw");
      }
-     glfwMakeContextCurrent (devices.window);
 
+     unsigned int const instanceVersion = getInstanceVersion ( );
      {
-          unsigned int enabledExtensionCount;
-          char const * const * enabledExtensionNames = glfwGetRequiredInstanceExtensions (&enabledExtensionCount);
+          unsigned int numberOfWindowExtensions = 0;
+          char const * const * windowExtensions = NULL;
+          if (isPresenting) windowExtensions = glfwGetRequiredInstanceExtensions (&numberOfWindowExtensions);
           char const * const layers [1] = {"VK_LAYER_KHRONOS_validation"};
+          enum validation validation = options.validation;
+          if (validation != VALIDATION_NONE && ! isLayerAvailable (layers [0]))
+          {
+               logWarning ("Validation %s was asked for, but %s is not installed.", validationNames [validation], layers [0]);
+               validation = VALIDATION_NONE;
+          }
+          VkBool32 isDebugUtils = isInstanceExtensionAvailable (NULL, VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+          if (! isDebugUtils && validation != VALIDATION_NONE) isDebugUtils = isInstanceExtensionAvailable (layers [0], VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+#ifdef NDEBUG
+          isDebugUtils = isDebugUtils && validation != VALIDATION_NONE;
+#endif
+          unsigned int enabledExtensionCount = 0;
+          char const * * enabledExtensionNames = xcalloc (numberOfWindowExtensions + 1, sizeof (char const *));
+          for (unsigned int i = 0; i < numberOfWindowExtensions; ++i) enabledExtensionNames [enabledExtensionCount++] = windowExtensions [i];
+          if (isDebugUtils) enabledExtensionNames [enabledExtensionCount++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+          VkValidationFeatureEnableEXT const gpuFeatures [ ] = {VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_EXT, VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_RESERVE_BINDING_SLOT_EXT};
+          VkValidationFeatureEnableEXT const synchronizationFeatures [ ] = {VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT};
+          VkDebugUtilsMessengerCreateInfoEXT const messengerInfo =
+               {.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
+                .pNext = NULL,
+                .flags = 0,
+                .messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
+                .messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
+                .pfnUserCallback = routeValidationMessage,
+                .pUserData = NULL,
+               };
+          VkValidationFeaturesEXT const features =
+               {.sType = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT,
+                .pNext = isDebugUtils ? & messengerInfo : NULL,
+                .enabledValidationFeatureCount = validation == VALIDATION_GPU ? 2 : 1,
+                .pEnabledValidationFeatures = validation == VALIDATION_GPU ? gpuFeatures : synchronizationFeatures,
+                .disabledValidationFeatureCount = 0,
+                .pDisabledValidationFeatures = NULL,
+               };
+          void const * pointerToNext = isDebugUtils ? & messengerInfo : NULL;
+          if (validation == VALIDATION_GPU || validation == VALIDATION_SYNCHRONIZATION) pointerToNext = & features;
+          const VkApplicationInfo application =
+               {.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+                .pNext = NULL,
+                .pApplicationName = "Hello World",
+                .applicationVersion = 0,
+                .pEngineName = NULL,
+                .engineVersion = 0,
+                .apiVersion = instanceVersion,
+               };
           const VkInstanceCreateInfo info =
                {.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
-                .pNext = NULL,
+                .pNext = pointerToNext,
                 .flags = 0,
-                .pApplicationInfo = NULL,
-                .enabledLayerCount = 1,
+                .pApplicationInfo = & application,
+                .enabledLayerCount = validation != VALIDATION_NONE ? 1 : 0,
                 .ppEnabledLayerNames = layers,
                 .enabledExtensionCount = enabledExtensionCount,
                 .ppEnabledExtensionNames = enabledExtensionNames,
                };
-          checkGlfwError ("Query Vulkan extensions");
-          for (unsigned int i = 0; i < info.enabledExtensionCount; ++i) printf ("Required extension: %s.\n", info.ppEnabledExtensionNames [i]);
+          if (isPresenting) checkGlfwError ("Query Vulkan extensions");
+          for (unsigned int i = 0; i < info.enabledExtensionCount; ++i) logDebug ("Required extension: %s.", info.ppEnabledExtensionNames [i]);
           try (vkCreateInstance(&info, NULL, &devices.vulkan), "Vulkan initialization");
+          free (enabledExtensionNames);
+          logInfo ("Validation: %s", validationNames [validation]);
+          devices.messenger = VK_NULL_HANDLE;
+          if (isDebugUtils)
+          {
+               PFN_vkCreateDebugUtilsMessengerEXT const createDebugUtilsMessenger = (PFN_vkCreateDebugUtilsMessengerEXT) vkGetInstanceProcAddr (devices.vulkan, "vkCreateDebugUtilsMessengerEXT");
+               setDebugUtilsObjectName = (PFN_vkSetDebugUtilsObjectNameEXT) vkGetInstanceProcAddr (devices.vulkan, "vkSetDebugUtilsObjectNameEXT");
+               if (createDebugUtilsMessenger) try (createDebugUtilsMessenger (devices.vulkan, & messengerInfo, NULL, & devices.messenger), "Creating the debug messenger");
+          }
+     }
+     markStartup (& startup, "instance");
+     devices.card = getPhysicalDevice (devices.vulkan, instanceVersion, isPresenting, options.deviceName);
+     devices.version = getDeviceVersion (devices.card, instanceVersion);
+     markStartup (& startup, "card");
+     VkBool32 isSynchronization2;
+     {
+          VkBool32 const isTimeline = isTimelineSupported (devices.card, devices.version);
+          isSynchronization2 = isSynchronization2Supported (devices.card, devices.version);
+          VkBool32 const isDynamicRendering = options.isDynamicRenderingEnabled && isDynamicRenderingSupported (devices.card, devices.version);
+          VkPhysicalDeviceTimelineSemaphoreFeatures timeline = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES, .pNext = NULL, .timelineSemaphore = VK_TRUE};
+          VkPhysicalDeviceSynchronization2Features synchronization2 = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES, .pNext = NULL, .synchronization2 = VK_TRUE};
+          VkPhysicalDeviceDynamicRenderingFeatures dynamicRendering = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES, .pNext = NULL, .dynamicRendering = VK_TRUE};
+          void * pointerToFeatures = NULL;
+          if (isTimeline) pointerToFeatures = & timeline;
+          if (isSynchronization2)
+          {
+               synchronization2.pNext = pointerToFeatures;
+               pointerToFeatures = & synchronization2;
+          }
+          if (isDynamicRendering)
+          {
+               dynamicRendering.pNext = pointerToFeatures;
+               pointerToFeatures = & dynamicRendering;
+          }
+          getLogicAndQueues (devices.vulkan, devices.card, isPresenting, options.isAsyncTransferEnabled, pointerToFeatures, & devices);
+          devices.pointerToSynchronization = getPointerToSynchronization (devices.logic, isTimeline);
+          logInfo ("Timeline semaphores: %s", isTimeline ? "yes" : "no");
+          if (isDynamicRendering)
+          {
+               cmdBeginRendering = (PFN_vkCmdBeginRendering) vkGetDeviceProcAddr (devices.logic, "vkCmdBeginRendering");
+               cmdEndRendering = (PFN_vkCmdEndRendering) vkGetDeviceProcAddr (devices.logic, "vkCmdEndRendering");
+          }
+          logInfo ("Rendering: %s", cmdBeginRendering ? "dynamic" : "render pass");
+     }
+     nameObject (devices.logic, VK_OBJECT_TYPE_QUEUE, devices.queue, "graphics queue");
+     if (devices.presentQueue != VK_NULL_HANDLE && devices.presentQueue != devices.queue) nameObject (devices.logic, VK_OBJECT_TYPE_QUEUE, devices.presentQueue, "present queue");
+     if (devices.transferQueue != VK_NULL_HANDLE) nameObject (devices.logic, VK_OBJECT_TYPE_QUEUE, devices.transferQueue, "transfer queue");
+     markStartup (& startup, "device");
+     devices.pointerToPipelines = getPointerToPipelines (devices.card, devices.logic, options.isPipelineCacheEnabled, options.pipelineCacheDirectory);
+     if (isPresenting)
+     {
+          glfwWindowHint (GLFW_CLIENT_API, GLFW_NO_API);
+          glfwWindowHint (GLFW_RESIZABLE, GLFW_TRUE);
+          VkBool32 isCopyable = VK_TRUE, isWritable = VK_TRUE;
+          for (unsigned int i = 0; i < devices.numberOfOutputs; ++i)
+          {
+               struct output * const pointerToOutput = & devices.outputs [i];
+               char title [32] = "Hello World";
+               if (i) snprintf (title, sizeof (title), "Hello World %u", i + 1);
+               pointerToOutput->window = glfwCreateWindow (size.x, size.y, title, NULL, NULL);
+               if (! pointerToOutput->window)
+               {
+                    glfwTerminate ( );
+                    exit (-1);
+               }
+               glfwSetWindowUserPointer (pointerToOutput->window, pointerToOutput);
+               glfwSetFramebufferSizeCallback (pointerToOutput->window, resize);
+               glfwSetWindowRefreshCallback (pointerToOutput->window, damageOnRefresh);
+               glfwSetWindowFocusCallback (pointerToOutput->window, damageOnFocus);
+               glfwSetKeyCallback (pointerToOutput->window, damageOnKey);
+               glfwSetMouseButtonCallback (pointerToOutput->window, damageOnButton);
+               glfwSetCursorPosCallback (pointerToOutput->window, damageOnCursor);
+               glfwSetScrollCallback (pointerToOutput->window, damageOnScroll);
+               try (glfwCreateWindowSurface (devices.vulkan, pointerToOutput->window, NULL, & pointerToOutput->surface), "Vulkan surface initialization");
+               checkSurfaceSupport (devices.card, devices.presentQueueFamilyIndex, pointerToOutput->surface);
+               if (! i) devices.format = getFormat (devices.card, pointerToOutput->surface);
+               else try (! isSurfaceFormatAvailable (devices.card, pointerToOutput->surface, devices.format), "Sharing the surface format between outputs");
+               VkSurfaceCapabilitiesKHR capabilities;
+               try (vkGetPhysicalDeviceSurfaceCapabilitiesKHR (devices.card, pointerToOutput->surface, & capabilities), "Query surface capabilities");
+               if (! (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) isCopyable = VK_FALSE;
+               if (! (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) isWritable = VK_FALSE;
+          }
+          atomic_store (& isWindowOpen, 1);
+          markStartup (& startup, "window");
+          if (options.captureInterval)
+          {
+               if (isCopyable) devices.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+               else logWarning ("The surface cannot be copied from, capture is disabled.");
+          }
+          if (options.isOverlayEnabled || options.isReplayEnabled)
+          {
+               if (isWritable) devices.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+               else logWarning ("The surface cannot be copied to, the overlay and replay are disabled.");
+          }
+          for (unsigned int i = 0; i < devices.numberOfOutputs; ++i)
+          {
+               struct output * const pointerToOutput = & devices.outputs [i];
+               pointerToOutput->chain = getSwapchain (devices.card, devices.logic, pointerToOutput->surface, devices.format, & pointerToOutput->size, options.imageCount, options.presentPolicy, options.presentMode, devices.imageUsage, (unsigned int [ ]) {devices.queueFamilyIndex, devices.presentQueueFamilyIndex}, VK_NULL_HANDLE, & pointerToOutput->presentMode);
+          }
+          markStartup (& startup, "swapchain");
+     }
+     else
+     {
+          devices.format = getHeadlessFormat (devices.card);
+          devices.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+     }
+     devices.pointerToAllocator = getPointerToAllocator (devices.card, devices.logic);
+     devices.pool = getPool (devices.logic, devices.queueFamilyIndex, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+     devices.pointerToFrames = getPointerToFrames (devices.logic, devices.pool, options.framesInFlight);
+     devices.pointerToStaging = getPointerToStaging (devices.logic, devices.pointerToAllocator, devices.pointerToFrames, devices.pointerToSynchronization, devices.transferQueue, devices.transferQueueFamilyIndex, devices.queueFamilyIndex, STAGING_SIZE);
+     devices.pointerToArena = getPointerToArena (devices.logic, devices.pointerToAllocator, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ARENA_SIZE, devices.pointerToFrames->count);
+     nameObject (devices.logic, VK_OBJECT_TYPE_BUFFER, devices.pointerToArena->buffer, "frame arena");
+     devices.pointerToGraph = getPointerToGraph (devices.logic, devices.pointerToAllocator, devices.pointerToFrames->count, isSynchronization2);
+     devices.pointerToCapture = NULL;
+     if (options.captureInterval && devices.imageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+          devices.pointerToCapture = getPointerToCapture (devices.card, devices.logic, devices.pointerToAllocator, devices.format.format, devices.pointerToFrames->count, options);
+     VkBool32 const isReplay = options.isReplayEnabled && ! devices.pointerToCapture && devices.imageUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT && isBlitSupported (devices.card, REPLAY_SWATCH_FORMAT, devices.format.format);
+     if (options.isReplayEnabled && devices.pointerToCapture) logWarning ("Capture records every frame, replay is disabled.");
+     else if (options.isReplayEnabled && ! isReplay) logWarning ("Replay cannot blit its colour into format %d, replay is disabled.", devices.format.format);
+     for (unsigned int i = 0; i < devices.numberOfOutputs; ++i)
+          devices.outputs [i].pointerToReplay = isReplay ? getPointerToReplay (devices.logic, devices.pointerToAllocator, devices.queueFamilyIndex, devices.pointerToFrames->count) : NULL;
+     devices.pointerToOverlay = NULL;
+     if (options.isOverlayEnabled && ! isReplay && devices.imageUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+     {
+          if (isOverlayFormat (devices.format.format) && isBlitSupported (devices.card, devices.format.format, devices.format.format)) devices.pointerToOverlay = getPointerToOverlay (devices.pointerToArena, devices.format.format, devices.numberOfOutputs);
+          else logWarning ("The overlay cannot write format %d, the overlay is disabled.", devices.format.format);
+     }
+     devices.pointerToWorkers = options.numberOfWorkers && ! isReplay ? getPointerToWorkers (devices.logic, devices.queueFamilyIndex, devices.pointerToFrames->count * devices.numberOfOutputs, options.numberOfWorkers) : NULL;
+     devices.pointerToPacing = getPointerToPacing (options.pacing, options.targetRate);
+     devices.pointerToTimings = getPointerToTimings (devices.card, devices.logic, devices.queueFamilyIndex, devices.pointerToFrames->count, options.summaryInterval, options.timingsPath);
+     markStartup (& startup, "frames");
+     devices.renderPass = cmdBeginRendering ? VK_NULL_HANDLE : getRenderPass (devices.logic, devices.format.format, devices.pointerToWorkers ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_CLEAR);
+     for (unsigned int i = 0; i < devices.numberOfOutputs; ++i)
+     {
+          struct output * const pointerToOutput = & devices.outputs [i];
+          if (pointerToOutput->chain != VK_NULL_HANDLE)
+               pointerToOutput->pointerToImages = getPointerToSwapchainImages (devices.logic, devices.pointerToSynchronization, pointerToOutput->chain, devices.format.format, devices.renderPass, pointerToOutput->size);
+          else
+          {
+               unsigned int const imageCount = options.imageCount > devices.pointerToFrames->count ? options.imageCount : devices.pointerToFrames->count;
+               pointerToOutput->pointerToImages = getPointerToHeadlessImages (devices.pointerToAllocator, devices.logic, devices.pointerToSynchronization, imageCount, devices.format.format, devices.imageUsage, devices.renderPass, size);
+          }
+          pointerToOutput->imageAvailable = xcalloc (devices.pointerToFrames->count, sizeof (VkSemaphore));
+          for (unsigned int slot = 0; slot < devices.pointerToFrames->count; ++slot) pointerToOutput->imageAvailable [slot] = takeSemaphore (devices.pointerToSynchronization);
      }
-     try (glfwCreateWindowSurface (devices.vulkan, devices.window, NULL, &devices.surface), "Vulkan surface initialization");
-     devices.card = getSomePhysicalDevice (devices.vulkan);
-     getLogicAndQueue (devices.card, devices.surface, &devices.logic, &devices.queue, &devices.queueFamilyIndex);
-     devices.format = getFormat (devices.card, devices.surface);
-     devices.chain = getSwapchain (devices.card, devices.logic, devices.surface, devices.format, size);
-     devices.pool = getPool (devices.logic, devices.queueFamilyIndex);
-     devices.buffer = getBuffer (devices.logic, devices.pool);
-     devices.renderPass = getRenderPass (devices.logic, devices.format.format);
-     devices.pointerToImages = getPointerToImages (devices.logic, devices.chain, devices.format.format, devices.renderPass, size);
-     printf ("Images in the swap chain: %d\n", devices.pointerToImages->count);
+     markStartup (& startup, "images");
+     waitForPipelines (devices.pointerToPipelines);
+     markStartup (& startup, "cache load");
+     devices.startupTime = printStartup (& startup);
+     describeSwapchain (devices, devices.pointerToTimings->configuration, sizeof (devices.pointerToTimings->configuration));
+     logInfo ("Swapchain: %s", devices.pointerToTimings->configuration);
      return devices;
 }
 
+void retireSwapchain (struct devices * const pointerToDevices, struct output * const pointerToOutput)
+{
+     struct retirements * const pointerToRetirements = pointerToOutput->pointerToRetirements;
+     if (pointerToRetirements->number == pointerToRetirements->capacity)
+     {
+          pointerToRetirements->capacity = pointerToRetirements->capacity ? 2 * pointerToRetirements->capacity : 4;
+          pointerToRetirements->entries = xrealloc (pointerToRetirements->entries, pointerToRetirements->capacity * sizeof (struct retirement));
+     }
+     pointerToRetirements->entries [pointerToRetirements->number++] = (struct retirement) {.chain = pointerToOutput->chain, .pointerToImages = pointerToOutput->pointerToImages, .lastFrame = pointerToDevices->pointerToFrames->numberOfSubmits};
+}
+
+void collectRetirements (struct devices const devices, VkBool32 const isFinal)
+{
+     for (unsigned int output = 0; output < devices.numberOfOutputs; ++output)
+     {
+          struct retirements * const pointerToRetirements = devices.outputs [output].pointerToRetirements;
+          unsigned int kept = 0;
+          for (unsigned int i = 0; i < pointerToRetirements->number; ++i)
+          {
+               struct retirement * const pointerToRetirement = & pointerToRetirements->entries [i];
+               if (! isFinal && ! isFrameCompleted (devices.pointerToFrames, pointerToRetirement->lastFrame))
+               {
+                    pointerToRetirements->entries [kept++] = * pointerToRetirement;
+                    continue;
+               }
+               logDebug ("Destroying retired swapchain %p.", (void *) pointerToRetirement->chain);
+               leaveImages (devices.logic, devices.pointerToAllocator, pointerToRetirement->pointerToImages);
+               vkDestroySwapchainKHR (devices.logic, pointerToRetirement->chain, NULL);
+          }
+          pointerToRetirements->number = kept;
+     }
+}
+
+VkBool32 recreateSwapchain (struct devices * const pointerToDevices, struct output * const pointerToOutput)
+{
+     int width, height;
+     glfwGetFramebufferSize (pointerToOutput->window, & width, & height);
+     if (width == 0 || height == 0)
+     {
+          pointerToOutput->isStale = 1;
+          return VK_FALSE;
+     }
+     double const start = getTime ( );
+     pointerToOutput->isStale = 0;
+     retireSwapchain (pointerToDevices, pointerToOutput);
+     pointerToOutput->size = (struct point) {.x = width, .y = height};
+     pointerToOutput->chain = getSwapchain (pointerToDevices->card, pointerToDevices->logic, pointerToOutput->surface, pointerToDevices->format, & pointerToOutput->size, pointerToDevices->requestedImageCount, pointerToDevices->presentPolicy, pointerToDevices->requestedPresentMode, pointerToDevices->imageUsage, (unsigned int [ ]) {pointerToDevices->queueFamilyIndex, pointerToDevices->presentQueueFamilyIndex}, pointerToOutput->chain, & pointerToOutput->presentMode);
+     pointerToOutput->pointerToImages = getPointerToSwapchainImages (pointerToDevices->logic, pointerToDevices->pointerToSynchronization, pointerToOutput->chain, pointerToDevices->format.format, pointerToDevices->renderPass, pointerToOutput->size);
+     double const duration = 1e3 * (getTime ( ) - start);
+     pointerToOutput->pointerToRetirements->numberOfRecreations++;
+     pointerToOutput->pointerToRetirements->recreationTime += duration;
+     describeSwapchain (* pointerToDevices, pointerToDevices->pointerToTimings->configuration, sizeof (pointerToDevices->pointerToTimings->configuration));
+     logInfo ("Swapchain of output %u recreated at %d, %d in %.2f ms: %s", (unsigned int) (pointerToOutput - pointerToDevices->outputs), width, height, duration, pointerToDevices->pointerToTimings->configuration);
+     return VK_TRUE;
+}
+
 int leave (const struct devices devices)
 {
      try (vkDeviceWaitIdle (devices.logic), "waiting for device to finish work");
-     for (unsigned int i = 0; i < devices.pointerToImages->count; ++i)
+     collectRetirements (devices, VK_TRUE);
+     for (unsigned int output = 0; output < devices.numberOfOutputs; ++output)
      {
-          vkDestroyImageView (devices.logic, devices.pointerToImages->views [i], NULL);
-          vkDestroyFramebuffer (devices.logic, devices.pointerToImages->frames [i], NULL);
+          struct output * const pointerToOutput = & devices.outputs [output];
+          struct retirements * const pointerToRetirements = pointerToOutput->pointerToRetirements;
+          if (pointerToRetirements->numberOfRecreations)
+               logInfo ("Swapchain recreations of output %u: %u, %.2f ms on average", output, pointerToRetirements->numberOfRecreations, pointerToRetirements->recreationTime / pointerToRetirements->numberOfRecreations);
+          free (pointerToRetirements->entries);
+          free (pointerToRetirements);
+          leaveImages (devices.logic, devices.pointerToAllocator, pointerToOutput->pointerToImages);
+          for (unsigned int i = 0; i < devices.pointerToFrames->count; ++i) giveSemaphore (devices.pointerToSynchronization, pointerToOutput->imageAvailable [i]);
+          free (pointerToOutput->imageAvailable);
+          if (pointerToOutput->pointerToReplay) leaveReplay (devices.pointerToAllocator, pointerToOutput->pointerToReplay);
      }
-     free (devices.pointerToImages->images);
-     free (devices.pointerToImages->views);
-     free (devices.pointerToImages->frames);
-     free (devices.pointerToImages);
+     leaveStaging (devices.pointerToAllocator, devices.pointerToStaging);
+     for (unsigned int i = 0; i < devices.pointerToFrames->count; ++i)
+          if (devices.pointerToFrames->inFlight [i] != VK_NULL_HANDLE) giveFence (devices.pointerToSynchronization, devices.pointerToFrames->inFlight [i]);
+     free (devices.pointerToFrames->buffers);
+     free (devices.pointerToFrames->inFlight);
+     free (devices.pointerToFrames->timelineValues);
+     free (devices.pointerToFrames->submitted);
+     free (devices.pointerToFrames->completed);
+     free (devices.pointerToFrames);
+     if (devices.pointerToWorkers) leaveWorkers (devices.pointerToWorkers);
+     leaveTimings (devices.logic, devices.pointerToTimings);
+     logInfo ("Synchronization objects created: %u", devices.pointerToSynchronization->createdInTotal);
+     leaveSynchronization (devices.pointerToSynchronization);
+     if (devices.pointerToCapture) leaveCapture (devices.pointerToCapture);
+     if (devices.pointerToOverlay) leaveOverlay (devices.pointerToOverlay);
+     leaveArena (devices.logic, devices.pointerToAllocator, devices.pointerToArena);
+     leaveGraph (devices.pointerToGraph);
+     leaveAllocator (devices.pointerToAllocator);
+     leavePipelines (devices.pointerToPipelines);
      vkDestroyCommandPool (devices.logic, devices.pool, NULL);
      vkDestroyRenderPass (devices.logic, devices.renderPass, NULL);
-     vkDestroySwapchainKHR (devices.logic, devices.chain, NULL);
-     vkDestroySurfaceKHR (devices.vulkan, devices.surface, NULL);
+     cmdBeginRendering = NULL;
+     cmdEndRendering = NULL;
+     for (unsigned int i = 0; i < devices.numberOfOutputs; ++i)
+     {
+          if (devices.outputs [i].chain != VK_NULL_HANDLE) vkDestroySwapchainKHR (devices.logic, devices.outputs [i].chain, NULL);
+          if (devices.outputs [i].surface != VK_NULL_HANDLE) vkDestroySurfaceKHR (devices.vulkan, devices.outputs [i].surface, NULL);
+     }
      vkDestroyDevice (devices.logic, NULL);
+     if (devices.messenger != VK_NULL_HANDLE)
+     {
+          PFN_vkDestroyDebugUtilsMessengerEXT const destroyDebugUtilsMessenger = (PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr (devices.vulkan, "vkDestroyDebugUtilsMessengerEXT");
+          if (destroyDebugUtilsMessenger) destroyDebugUtilsMessenger (devices.vulkan, devices.messenger, NULL);
+     }
+     setDebugUtilsObjectName = NULL;
      vkDestroyInstance (devices.vulkan, NULL);
-     glfwDestroyWindow (devices.window);
-     glfwTerminate ( );
+     if (devices.outputs [0].window)
+     {
+          atomic_store (& isWindowOpen, 0);
+          for (unsigned int i = 0; i < devices.numberOfOutputs; ++i) glfwDestroyWindow (devices.outputs [i].window);
+          glfwTerminate ( );
+     }
+     free (devices.outputs);
+     if (devices.pointerToPacing->mode == PACING_IDLE && devices.pointerToPacing->numberOfRedraws)
+          logInfo ("Idle pacing: %u redraws after %u wakeups, %.3f ms from damage to present on average", devices.pointerToPacing->numberOfRedraws, devices.pointerToPacing->numberOfWakeups, 1e3 * devices.pointerToPacing->latency / devices.pointerToPacing->numberOfRedraws);
+     free (devices.pointerToPacing);
+     stopLogging ( );
      return 0;
 }
 
-void mainLoop (const struct devices devices, struct point const size)
+VkBool32 mainLoop (struct devices * const pointerToDevices)
 {
      static unsigned int mainLoopCounter = 0;
-     glfwSwapBuffers (devices.window);
-     glfwPollEvents ( );
-     unsigned int imageIndex;
+     struct devices const devices = * pointerToDevices;
+     if (! waitForDamage (devices.pointerToPacing, devices.numberOfOutputs, devices.outputs)) return VK_FALSE;
+     struct frames * const pointerToFrames = devices.pointerToFrames;
+     struct synchronization * const pointerToSynchronization = devices.pointerToSynchronization;
+     struct timings * const pointerToTimings = devices.pointerToTimings;
+     double const frameStart = getTime ( );
+     double phaseStart = frameStart;
+     beginTimings (pointerToTimings);
+     unsigned int const frameIndex = mainLoopCounter % pointerToFrames->count;
+     VkCommandBuffer const buffer = pointerToFrames->buffers [frameIndex];
+     VkSemaphore uploaded = VK_NULL_HANDLE;
+     pointerToSynchronization->createdInFrame = 0;
+     unsigned int const numberOfOutputs = devices.numberOfOutputs;
+     VkBool32 const isPresenting = devices.outputs [0].chain != VK_NULL_HANDLE;
+     if (isPresenting && devices.pointerToPacing->mode != PACING_IDLE) glfwPollEvents ( );
+     for (unsigned int i = 0; i < numberOfOutputs; ++i) if (isPresenting && devices.outputs [i].isStale) recreateSwapchain (pointerToDevices, & devices.outputs [i]);
+     phaseStart = recordPhase (pointerToTimings, PHASE_POLL, phaseStart);
+     waitForFrame (devices.logic, pointerToFrames, pointerToSynchronization, frameIndex);
+     resetArena (devices.pointerToArena, frameIndex);
+     readTimestamps (pointerToTimings, devices.logic, frameIndex);
+     if (devices.pointerToCapture) collectCapture (devices.pointerToCapture, frameIndex);
+     beginStaging (devices.pointerToStaging, frameIndex);
+     collectRetirements (devices, VK_FALSE);
+     phaseStart = recordPhase (pointerToTimings, PHASE_WAIT, phaseStart);
+     unsigned int numberOfDrawnOutputs = 0;
+     for (unsigned int i = 0; i < numberOfOutputs; ++i)
+     {
+          struct output * const pointerToOutput = & devices.outputs [i];
+          pointerToOutput->isDrawn = VK_FALSE;
+          if (isPresenting)
+          {
+               if (pointerToOutput->isStale) continue;
+               VkResult result;
+               while ((result = vkAcquireNextImageKHR (devices.logic, pointerToOutput->chain, -1, pointerToOutput->imageAvailable [frameIndex], VK_NULL_HANDLE, & pointerToOutput->imageIndex)) == VK_ERROR_OUT_OF_DATE_KHR)
+                    if (! recreateSwapchain (pointerToDevices, pointerToOutput)) break;
+               if (result == VK_ERROR_OUT_OF_DATE_KHR) continue;
+               if (result == VK_SUBOPTIMAL_KHR) markStale (pointerToOutput);
+               else try (result, "Acquiring next image");
+          }
+          else pointerToOutput->imageIndex = mainLoopCounter % pointerToOutput->pointerToImages->count;
+          pointerToOutput->isDrawn = VK_TRUE;
+          numberOfDrawnOutputs++;
+          logTrace ("Image view acquired for output %u: %u at %p.", i, pointerToOutput->imageIndex, (void *) & pointerToOutput->pointerToImages->images [pointerToOutput->imageIndex]);
+     }
+     if (! numberOfDrawnOutputs)
+     {
+          glfwWaitEventsTimeout (IDLE_WAKE_SECONDS);
+          return VK_FALSE;
+     }
+     phaseStart = recordPhase (pointerToTimings, PHASE_ACQUIRE, phaseStart);
+     VkClearValue const clearValue = {.color = {.float32 = {fabsf ((float) (mainLoopCounter % 1000) - 500.0f) / 500, 0, 1 - fabsf ((float) (mainLoopCounter % 1000) - 500.0f) / 500, 1}}};
+     unsigned int numberOfBuffers = 0;
+     VkCommandBuffer buffers [numberOfOutputs];
+     if (devices.outputs [0].pointerToReplay)
      {
-          VkFence fence;
+          for (unsigned int i = 0; i < numberOfOutputs; ++i)
           {
-               VkFenceCreateInfo info = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, .pNext = NULL, .flags = 0};
-               try (vkCreateFence (devices.logic, & info, NULL, & fence), "Get a fence");
+               struct output * const pointerToOutput = & devices.outputs [i];
+               if (! pointerToOutput->isDrawn) continue;
+               recordReplay (pointerToOutput->pointerToReplay, devices, pointerToOutput, i == 0);
+               buffers [numberOfBuffers++] = takeReplay (pointerToOutput->pointerToReplay, pointerToOutput->imageIndex, frameIndex, clearValue);
           }
-          try (vkAcquireNextImageKHR (devices.logic, devices.chain, -1, VK_NULL_HANDLE, fence, &imageIndex), "Acquiring next image");
-          try (vkWaitForFences (devices.logic, 1, & fence, VK_TRUE, -1), "Waiting for image acquisition");
-          vkDestroyFence (devices.logic, fence, NULL);
-          printf ("Image view acquired: %d at %p.\n", imageIndex, & devices.pointerToImages->images [imageIndex]);
+          if (devices.outputs [0].isDrawn) markTimestamps (pointerToTimings, frameIndex);
      }
-     unsigned int imageIndices [ ] = {imageIndex};
+     else
      {
           VkCommandBufferBeginInfo info =
                {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -420,64 +4083,197 @@ void mainLoop (const struct devices devices, struct point const size)
                 .flags = 0,
                 .pInheritanceInfo = NULL,
                };
-          try (vkBeginCommandBuffer (devices.buffer, &info), "Begin buffer");
-          printf ("Framebuffer pointer: %p.\n", & devices.pointerToImages->frames [imageIndex]);
+          try (vkBeginCommandBuffer (buffer, &info), "Begin buffer");
+          beginTimestamps (pointerToTimings, buffer, frameIndex);
+          VkBool32 const isOverlayStreamed = devices.pointerToOverlay && streamOverlay (devices.pointerToOverlay, devices.pointerToStaging, frameIndex);
+          uploaded = endStaging (devices.pointerToStaging, buffer);
           {
-               VkClearValue clearValue = {.color = {.float32 = {fabsf ((float) (mainLoopCounter % 1000) - 500.0f) / 500, 0, 1 - fabsf ((float) (mainLoopCounter % 1000) - 500.0f) / 500, 1}}};
-               VkRenderPassBeginInfo info =
-                    {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-                     .pNext = NULL,
-                     .renderPass = devices.renderPass,
-                     .framebuffer = devices.pointerToImages->frames [imageIndex],
-                     .renderArea = (VkRect2D) {.offset.x = 0, .offset.y = 0, .extent.width = size.x, .extent.height = size.y},
-                     .clearValueCount = 1,
-                     .pClearValues = & clearValue,
-                    };
-               vkCmdBeginRenderPass (devices.buffer, & info, VK_SUBPASS_CONTENTS_INLINE);
-               vkCmdEndRenderPass (devices.buffer);
+               struct graph * const pointerToGraph = devices.pointerToGraph;
+               struct drawing drawings [numberOfOutputs];
+               resetGraph (pointerToGraph, frameIndex);
+               for (unsigned int i = 0; i < numberOfOutputs; ++i)
+               {
+                    struct output const * const pointerToOutput = & devices.outputs [i];
+                    if (! pointerToOutput->isDrawn) continue;
+                    struct images const * const pointerToImages = pointerToOutput->pointerToImages;
+                    unsigned int const imageIndex = pointerToOutput->imageIndex;
+                    drawings [i] = (struct drawing) {.renderPass = devices.renderPass, .framebuffer = pointerToImages->frames ? pointerToImages->frames [imageIndex] : VK_NULL_HANDLE, .view = pointerToImages->views [imageIndex], .format = devices.format.format, .size = pointerToOutput->size, .clearValue = clearValue, .pointerToWorkers = devices.pointerToWorkers, .slot = frameIndex * numberOfOutputs + i};
+                    unsigned int const target = importImage (pointerToGraph, pointerToImages->images [imageIndex], VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+                    exportResource (pointerToGraph, target, isPresenting ? GRAPH_PRESENT : GRAPH_TRANSFER_SOURCE);
+                    useResource (pointerToGraph, addGraphPass (pointerToGraph, "draw", recordDrawing, & drawings [i], VK_FALSE), target, GRAPH_COLOR_ATTACHMENT);
+                    if (isOverlayStreamed) drawOverlay (devices.pointerToOverlay, pointerToGraph, target, i, pointerToOutput->size);
+                    if (devices.pointerToCapture && i == 0) captureImage (devices.pointerToCapture, pointerToGraph, target, frameIndex, mainLoopCounter, pointerToOutput->size);
+               }
+               executeGraph (pointerToGraph, buffer);
           }
-          try (vkEndCommandBuffer (devices.buffer), "End buffer");
+          endTimestamps (pointerToTimings, buffer, frameIndex);
+          try (vkEndCommandBuffer (buffer), "End buffer");
+          buffers [numberOfBuffers++] = buffer;
      }
+     phaseStart = recordPhase (pointerToTimings, PHASE_RECORD, phaseStart);
+     unsigned int numberOfPresents = 0;
+     VkSemaphore signalSemaphores [numberOfOutputs + 1];
+     VkSwapchainKHR chains [numberOfOutputs];
+     unsigned int imageIndices [numberOfOutputs];
+     struct output * presentedOutputs [numberOfOutputs];
      {
+          unsigned int numberOfWaits = 0;
+          VkSemaphore waitSemaphores [numberOfOutputs + 1];
+          VkPipelineStageFlags waitStages [numberOfOutputs + 1];
+          uint64_t waitValues [numberOfOutputs + 1];
+          uint64_t signalValues [numberOfOutputs + 1];
+          for (unsigned int i = 0; i < numberOfOutputs; ++i)
+          {
+               struct output * const pointerToOutput = & devices.outputs [i];
+               if (! isPresenting || ! pointerToOutput->isDrawn) continue;
+               waitSemaphores [numberOfWaits] = pointerToOutput->imageAvailable [frameIndex];
+               waitValues [numberOfWaits] = 0;
+               waitStages [numberOfWaits++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+               signalSemaphores [numberOfPresents] = pointerToOutput->pointerToImages->renderFinished [pointerToOutput->imageIndex];
+               signalValues [numberOfPresents] = 0;
+               chains [numberOfPresents] = pointerToOutput->chain;
+               imageIndices [numberOfPresents] = pointerToOutput->imageIndex;
+               presentedOutputs [numberOfPresents++] = pointerToOutput;
+          }
+          if (uploaded != VK_NULL_HANDLE)
+          {
+               waitSemaphores [numberOfWaits] = uploaded;
+               waitValues [numberOfWaits] = 0;
+               waitStages [numberOfWaits++] = STAGING_CONSUMER_STAGES;
+          }
+          VkBool32 const isTimeline = pointerToSynchronization->timeline != VK_NULL_HANDLE;
+          unsigned int numberOfSignals = numberOfPresents;
+          if (isTimeline)
+          {
+               pointerToFrames->timelineValues [frameIndex] = ++ pointerToSynchronization->timelineValue;
+               signalSemaphores [numberOfSignals] = pointerToSynchronization->timeline;
+               signalValues [numberOfSignals++] = pointerToSynchronization->timelineValue;
+          }
+          VkTimelineSemaphoreSubmitInfo const timelineInfo =
+               {.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                .pNext = NULL,
+                .waitSemaphoreValueCount = numberOfWaits,
+                .pWaitSemaphoreValues = waitValues,
+                .signalSemaphoreValueCount = numberOfSignals,
+                .pSignalSemaphoreValues = signalValues,
+               };
           VkSubmitInfo info =
                {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                .pNext = NULL,
-                .waitSemaphoreCount = 0,
-                .pWaitSemaphores = NULL,
-                .pWaitDstStageMask = NULL,
-                .commandBufferCount = 1,
-                .pCommandBuffers = &devices.buffer,
-                .signalSemaphoreCount = 0,
-                .pSignalSemaphores = NULL,
+                .pNext = isTimeline ? & timelineInfo : NULL,
+                .waitSemaphoreCount = numberOfWaits,
+                .pWaitSemaphores = waitSemaphores,
+                .pWaitDstStageMask = waitStages,
+                .commandBufferCount = numberOfBuffers,
+                .pCommandBuffers = buffers,
+                .signalSemaphoreCount = numberOfSignals,
+                .pSignalSemaphores = signalSemaphores,
                };
-          try (vkQueueSubmit (devices.queue, 1, &info, VK_NULL_HANDLE), "Submission of the command buffer to the queue");
+          VkFence fence = VK_NULL_HANDLE;
+          if (! isTimeline) fence = pointerToFrames->inFlight [frameIndex] = takeFence (pointerToSynchronization);
+          pointerToFrames->submitted [frameIndex] = ++ pointerToFrames->numberOfSubmits;
+          try (vkQueueSubmit (devices.queue, 1, &info, fence), "Submission of the command buffer to the queue");
      }
+     phaseStart = recordPhase (pointerToTimings, PHASE_SUBMIT, phaseStart);
+     if (numberOfPresents)
      {
+          VkResult results [numberOfPresents];
           VkPresentInfoKHR info =
                {.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
                 .pNext= NULL,
-                .waitSemaphoreCount = 0,
-                .pWaitSemaphores = NULL,
-                .swapchainCount = 1,
-                .pSwapchains = &devices.chain,
+                .waitSemaphoreCount = numberOfPresents,
+                .pWaitSemaphores = signalSemaphores,
+                .swapchainCount = numberOfPresents,
+                .pSwapchains = chains,
                 .pImageIndices = imageIndices,
-                .pResults = NULL,
+                .pResults = results,
                };
-          try (vkQueuePresentKHR (devices.queue, &info), "Presentation");
+          VkResult const result = vkQueuePresentKHR (devices.presentQueue, &info);
+          if (result != VK_ERROR_OUT_OF_DATE_KHR && result != VK_SUBOPTIMAL_KHR) try (result, "Presentation");
+          for (unsigned int i = 0; i < numberOfPresents; ++i)
+          {
+               if (results [i] == VK_ERROR_OUT_OF_DATE_KHR || results [i] == VK_SUBOPTIMAL_KHR) markStale (presentedOutputs [i]);
+               else try (results [i], "Presentation");
+          }
+          phaseStart = recordPhase (pointerToTimings, PHASE_PRESENT, phaseStart);
      }
-     try (vkQueueWaitIdle (devices.queue), "Waiting for the queue to become idle");
+     pace (devices.pointerToPacing);
+     recordPhase (pointerToTimings, PHASE_PACE, phaseStart);
+     logTrace ("Main loop counter: %u, synchronization objects created: %u.", mainLoopCounter, pointerToSynchronization->createdInFrame);
+     if (pointerToSynchronization->createdInFrame && mainLoopCounter >= pointerToFrames->count)
+          logWarning ("Frame %u created %u synchronization objects.", mainLoopCounter, pointerToSynchronization->createdInFrame);
+     endTimings (pointerToTimings, frameStart);
+     mainLoopCounter++;
+     return VK_TRUE;
+}
+
+unsigned int getDefaultNumberOfWorkers (void)
+{
+     long const numberOfProcessors = sysconf (_SC_NPROCESSORS_ONLN);
+     if (numberOfProcessors < 1) return 1;
+     return numberOfProcessors < 4 ? numberOfProcessors : 4;
+}
+
+enum pacingMode getPacingByName (char const * const name, unsigned int const targetRate)
+{
+     if (! name || ! * name) return targetRate ? PACING_TARGET : PACING_UNLIMITED;
+     if (! strcmp (name, "unlimited")) return PACING_UNLIMITED;
+     if (! strcmp (name, "target")) return PACING_TARGET;
+     if (! strcmp (name, "vsync")) return PACING_VSYNC;
+     if (! strcmp (name, "idle")) return PACING_IDLE;
+     logWarning ("Ignoring unknown pacing %s.", name);
+     return PACING_UNLIMITED;
+}
+
+struct options getOptions (void)
+{
+     struct options options =
+          {.size = {.x = getEnvironmentNumber ("WIDTH", 800), .y = getEnvironmentNumber ("HEIGHT", 600)},
+           .framesInFlight = getEnvironmentNumber ("FRAMES_IN_FLIGHT", 2),
+           .numberOfWorkers = getEnvironmentNumber ("WORKERS", getDefaultNumberOfWorkers ( )),
+           .imageCount = getEnvironmentNumber ("IMAGES", 0),
+           .presentPolicy = getPresentPolicyByName (getenv ("PRESENT_POLICY")),
+           .presentMode = getPresentModeByName (getenv ("PRESENT_MODE")),
+           .isHeadless = getEnvironmentNumber ("HEADLESS", 0) != 0,
+           .frameLimit = getEnvironmentNumber ("FRAMES", 0),
+           .targetRate = getEnvironmentNumber ("TARGET_FPS", 0),
+           .summaryInterval = getEnvironmentNumber ("TIMINGS_INTERVAL", 1),
+           .timingsPath = getenv ("TIMINGS_FILE"),
+           .validation = getValidationByName (getenv ("VALIDATION")),
+           .deviceName = getenv ("DEVICE"),
+           .isAsyncTransferEnabled = getEnvironmentNumber ("ASYNC_TRANSFER", 1) != 0,
+           .isPipelineCacheEnabled = getEnvironmentNumber ("PIPELINE_CACHE", 1) != 0,
+           .pipelineCacheDirectory = getenv ("PIPELINE_CACHE_DIR") ? getenv ("PIPELINE_CACHE_DIR") : ".",
+           .captureInterval = getEnvironmentNumber ("CAPTURE", 0),
+           .captureFormat = getCaptureFormatByName (getenv ("CAPTURE_FORMAT")),
+           .captureDirectory = getenv ("CAPTURE_DIR") ? getenv ("CAPTURE_DIR") : ".",
+           .numberOfCaptureBuffers = getEnvironmentNumber ("CAPTURE_BUFFERS", 0),
+           .isDynamicRenderingEnabled = getEnvironmentNumber ("DYNAMIC_RENDERING", 1) != 0,
+           .isReplayEnabled = getEnvironmentNumber ("REPLAY", 0) != 0,
+           .numberOfOutputs = getEnvironmentNumber ("OUTPUTS", 1),
+           .isOverlayEnabled = getEnvironmentNumber ("OVERLAY", 1) != 0,
+          };
+     options.pacing = getPacingByName (getenv ("PACING"), options.targetRate);
+     if (options.presentMode != VK_PRESENT_MODE_MAX_ENUM_KHR) options.presentPolicy = PRESENT_EXPLICIT;
+     else if (options.presentPolicy == PRESENT_EXPLICIT)
      {
-          struct timespec timeToSleep = {.tv_sec = 0, .tv_nsec = 1 << 20};
-          nanosleep (&timeToSleep, NULL);
+          logWarning ("The explicit present policy needs PRESENT_MODE, using fifo.");
+          options.presentMode = VK_PRESENT_MODE_FIFO_KHR;
      }
-     printf ("Main loop counter: %u.\n", mainLoopCounter);
-     mainLoopCounter++;
+     if ((options.pacing == PACING_VSYNC || options.pacing == PACING_IDLE) && options.presentPolicy != PRESENT_EXPLICIT) options.presentPolicy = PRESENT_POWER_SAVING;
+     return options;
 }
 
+#ifndef BENCHMARK
 int main (void)
 {
-     const struct point size = {.x = 800, .y = 600};
-     const struct devices devices = enter (size);
-     while (! glfwWindowShouldClose (devices.window)) mainLoop (devices, size);
+     const struct options options = getOptions ( );
+     struct devices devices = enter (options);
+     signal (SIGINT, interrupt);
+     for (unsigned int frame = 0; options.frameLimit == 0 || frame < options.frameLimit; )
+     {
+          if (isInterrupted || isWindowClosing (devices.numberOfOutputs, devices.outputs)) break;
+          if (mainLoop (& devices)) ++frame;
+     }
      return leave (devices);
 }
+#endif
@@ -0,0 +1,324 @@
+/* Logic tests without a device: cc -O2 tests.c $(cat compile_flags.txt) -o tests && ./tests */
+#define BENCHMARK
+#include "main.c"
+
+#define check(condition) do { ++numberOfChecks; if (! (condition)) { ++numberOfFailures; fprintf (stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); } } while (0)
+#define MAXIMUM_BATCHES 8
+
+struct batch
+{
+     unsigned int numberOfImageBarriers;
+     unsigned int numberOfBufferBarriers;
+     VkImageMemoryBarrier2 imageBarriers [4];
+     VkBufferMemoryBarrier2 bufferBarriers [4];
+     unsigned int numberOfRecordingsBefore;
+};
+
+static unsigned int numberOfChecks = 0;
+static unsigned int numberOfFailures = 0;
+static unsigned int numberOfBatches = 0;
+static struct batch batches [MAXIMUM_BATCHES];
+static unsigned int numberOfRecordings = 0;
+static char const * recordings [MAXIMUM_BATCHES];
+
+void recordBarriers (VkCommandBuffer const buffer, VkDependencyInfo const * const pointerToInfo)
+{
+     (void) buffer;
+     if (numberOfBatches == MAXIMUM_BATCHES) return;
+     struct batch * const pointerToBatch = & batches [numberOfBatches++];
+     pointerToBatch->numberOfImageBarriers = pointerToInfo->imageMemoryBarrierCount;
+     pointerToBatch->numberOfBufferBarriers = pointerToInfo->bufferMemoryBarrierCount;
+     pointerToBatch->numberOfRecordingsBefore = numberOfRecordings;
+     for (unsigned int i = 0; i < pointerToInfo->imageMemoryBarrierCount && i < 4; ++i) pointerToBatch->imageBarriers [i] = pointerToInfo->pImageMemoryBarriers [i];
+     for (unsigned int i = 0; i < pointerToInfo->bufferMemoryBarrierCount && i < 4; ++i) pointerToBatch->bufferBarriers [i] = pointerToInfo->pBufferMemoryBarriers [i];
+}
+
+void recordPass (VkCommandBuffer const buffer, void * const argument)
+{
+     (void) buffer;
+     if (numberOfRecordings < MAXIMUM_BATCHES) recordings [numberOfRecordings++] = argument;
+}
+
+void testBuddy (void)
+{
+     struct memoryBlock block = {.size = 16 * 256, .leafSize = 256, .order = 4};
+     unsigned int const numberOfNodes = (2u << block.order) - 1;
+     block.longest = xcalloc (numberOfNodes, sizeof (unsigned char));
+     for (unsigned int node = 0, level = 0; node < numberOfNodes; ++node)
+     {
+          if (node + 1 == 2u << level) ++level;
+          block.longest [node] = block.order - level + 1;
+     }
+     check (getBuddyOrder (256, 256) == 0);
+     check (getBuddyOrder (257, 256) == 1);
+     check (getBuddyOrder (1024, 256) == 2);
+     VkDeviceSize offsets [4];
+     check (takeBuddy (& block, 0, & offsets [0]) && offsets [0] == 0);
+     check (takeBuddy (& block, 0, & offsets [1]) && offsets [1] == 256);
+     check (takeBuddy (& block, 1, & offsets [2]) && offsets [2] == 512);
+     check (takeBuddy (& block, 2, & offsets [3]) && offsets [3] == 1024);
+     check (block.longest [0] == 4);
+     VkDeviceSize offset;
+     check (! takeBuddy (& block, 4, & offset));
+     giveBuddy (& block, offsets [1], 0);
+     check (takeBuddy (& block, 0, & offset) && offset == 256);
+     giveBuddy (& block, offsets [0], 0);
+     giveBuddy (& block, offset, 0);
+     check (block.longest [7] == 2 && block.longest [1] == 2);
+     giveBuddy (& block, offsets [2], 1);
+     giveBuddy (& block, offsets [3], 2);
+     check (block.longest [0] == 5);
+     check (takeBuddy (& block, 4, & offset) && offset == 0);
+     giveBuddy (& block, offset, 4);
+     for (unsigned int i = 0; i < 16; ++i) check (takeBuddy (& block, 0, & offset) && offset == i * 256u);
+     check (! takeBuddy (& block, 0, & offset));
+     for (unsigned int i = 0; i < 16; ++i) giveBuddy (& block, i * 256u, 0);
+     check (block.longest [0] == 5);
+     free (block.longest);
+}
+
+void testArena (void)
+{
+     struct arena arena = {.numberOfSlots = 2, .bytesPerSlot = 1024, .heads = xcalloc (2, sizeof (VkDeviceSize)), .allocation = {.offset = 4096}};
+     VkDeviceSize offset;
+     check (takeFromArena (& arena, 0, 100, 64, & offset) && offset == 0);
+     check (takeFromArena (& arena, 0, 100, 64, & offset) && offset == 128);
+     check (takeFromArena (& arena, 1, 512, 256, & offset) && offset == 1024);
+     check (takeFromArena (& arena, 1, 512, 256, & offset) && offset == 1536);
+     logLevel = LOG_ERROR;
+     check (! takeFromArena (& arena, 1, 1, 1, & offset) && arena.heads [1] == 1024);
+     check (! takeFromArena (& arena, 0, 900, 16, & offset) && arena.heads [0] == 228);
+     logLevel = LOG_INFO;
+     check (getArenaPointer (& arena, 128) == NULL && arena.peak == 1024);
+     resetArena (& arena, 1);
+     check (arena.heads [0] == 228 && arena.heads [1] == 0);
+     check (takeFromArena (& arena, 1, 1024, 256, & offset) && offset == 1024);
+     char memory [2048];
+     arena.allocation.pointer = memory;
+     check (getArenaPointer (& arena, 1536) == memory + 1536);
+     free (arena.heads);
+}
+
+void testStaging (void)
+{
+     VkFence inFlight [3] = {VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE};
+     uint64_t timelineValues [3] = {0}, submitted [3] = {0}, completed [3] = {0};
+     struct frames temporaryStructure = {.count = 3, .inFlight = inFlight, .timelineValues = timelineValues, .submitted = submitted, .completed = completed, .numberOfSubmits = 0};
+     struct frames * const pointerToFrames = xmalloc0 (sizeof (struct frames));
+     memcpy (pointerToFrames, & temporaryStructure, sizeof (temporaryStructure));
+     struct synchronization synchronization = {.timeline = VK_NULL_HANDLE};
+     char memory [1024];
+     struct staging staging = {.pointerToFrames = pointerToFrames, .pointerToSynchronization = & synchronization, .numberOfSlots = 3, .size = sizeof (memory), .allocation = {.pointer = memory}, .ends = xcalloc (3, sizeof (uint64_t))};
+     VkDeviceSize offset;
+     beginStaging (& staging, 0);
+     check (takeStaging (& staging, 400, 16, & offset) == memory && offset == 0);
+     check (takeStaging (& staging, 400, 16, & offset) == memory + 400 && offset == 400);
+     check (endStaging (& staging, VK_NULL_HANDLE) == VK_NULL_HANDLE && staging.ends [0] == 800);
+     beginStaging (& staging, 1);
+     check (takeStaging (& staging, 400, 16, & offset) == memory && offset == 0);
+     check (staging.numberOfStalls == 2 && staging.tail == 800 && staging.head == 1424);
+     logLevel = LOG_ERROR;
+     check (takeStaging (& staging, 700, 16, & offset) == NULL && staging.head == 1424);
+     logLevel = LOG_INFO;
+     check (staging.numberOfStalls == 4);
+     endStaging (& staging, VK_NULL_HANDLE);
+     beginStaging (& staging, 2);
+     check (takeStaging (& staging, 100, 256, & offset) == memory + 512 && offset == 512);
+     check (staging.numberOfStalls == 4 && staging.bytesInTotal == 1300);
+     free (staging.ends);
+     free (pointerToFrames);
+}
+
+void testGraph (void)
+{
+     struct graph * const pointerToGraph = getPointerToGraph (VK_NULL_HANDLE, NULL, 1, VK_FALSE);
+     pointerToGraph->cmdPipelineBarrier2 = recordBarriers;
+     VkImage const target = (VkImage) (uintptr_t) 0x10, unused = (VkImage) (uintptr_t) 0x20;
+     VkBuffer const readback = (VkBuffer) (uintptr_t) 0x30;
+
+     numberOfBatches = numberOfRecordings = 0;
+     resetGraph (pointerToGraph, 0);
+     unsigned int resource = importImage (pointerToGraph, target, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+     exportResource (pointerToGraph, resource, GRAPH_PRESENT);
+     unsigned int const unusedResource = importImage (pointerToGraph, unused, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_NONE);
+     useResource (pointerToGraph, addGraphPass (pointerToGraph, "draw", recordPass, "draw", VK_FALSE), resource, GRAPH_COLOR_ATTACHMENT);
+     useResource (pointerToGraph, addGraphPass (pointerToGraph, "dead", recordPass, "dead", VK_FALSE), unusedResource, GRAPH_COLOR_ATTACHMENT);
+     executeGraph (pointerToGraph, VK_NULL_HANDLE);
+     check (numberOfRecordings == 1 && ! strcmp (recordings [0], "draw"));
+     check (pointerToGraph->culledInTotal == 1);
+     check (numberOfBatches == 2);
+     check (batches [0].numberOfImageBarriers == 1 && batches [0].numberOfBufferBarriers == 0 && batches [0].numberOfRecordingsBefore == 0);
+     check (batches [0].imageBarriers [0].image == target);
+     check (batches [0].imageBarriers [0].oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && batches [0].imageBarriers [0].newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+     check (batches [0].imageBarriers [0].srcStageMask == VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT && batches [0].imageBarriers [0].srcAccessMask == VK_ACCESS_2_NONE);
+     check (batches [0].imageBarriers [0].dstAccessMask == graphAccesses [GRAPH_COLOR_ATTACHMENT].access);
+     check (batches [1].numberOfImageBarriers == 1 && batches [1].numberOfRecordingsBefore == 1);
+     check (batches [1].imageBarriers [0].oldLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL && batches [1].imageBarriers [0].newLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+     check (batches [1].imageBarriers [0].srcAccessMask == graphAccesses [GRAPH_COLOR_ATTACHMENT].access && batches [1].imageBarriers [0].dstStageMask == VK_PIPELINE_STAGE_2_NONE);
+
+     numberOfBatches = numberOfRecordings = 0;
+     resetGraph (pointerToGraph, 0);
+     resource = importImage (pointerToGraph, target, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+     exportResource (pointerToGraph, resource, GRAPH_PRESENT);
+     unsigned int const buffer = importBuffer (pointerToGraph, readback);
+     exportResource (pointerToGraph, buffer, GRAPH_HOST_READ);
+     useResource (pointerToGraph, addGraphPass (pointerToGraph, "draw", recordPass, "draw", VK_FALSE), resource, GRAPH_COLOR_ATTACHMENT);
+     unsigned int const copy = addGraphPass (pointerToGraph, "copy", recordPass, "copy", VK_FALSE);
+     useResource (pointerToGraph, copy, resource, GRAPH_TRANSFER_SOURCE);
+     useResource (pointerToGraph, copy, buffer, GRAPH_TRANSFER_DESTINATION);
+     useResource (pointerToGraph, addGraphPass (pointerToGraph, "inspect", recordPass, "inspect", VK_TRUE), resource, GRAPH_TRANSFER_SOURCE);
+     executeGraph (pointerToGraph, VK_NULL_HANDLE);
+     check (numberOfRecordings == 3);
+     check (numberOfBatches == 3);
+     check (batches [1].numberOfImageBarriers == 1 && batches [1].numberOfBufferBarriers == 0);
+     check (batches [1].imageBarriers [0].newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && batches [1].imageBarriers [0].dstStageMask == VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+     check (batches [2].numberOfRecordingsBefore == 3);
+     check (batches [2].numberOfImageBarriers == 1 && batches [2].numberOfBufferBarriers == 1);
+     check (batches [2].imageBarriers [0].oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && batches [2].imageBarriers [0].newLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+     check (batches [2].imageBarriers [0].srcStageMask & VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+     check (batches [2].bufferBarriers [0].buffer == readback && batches [2].bufferBarriers [0].srcAccessMask == VK_ACCESS_2_TRANSFER_WRITE_BIT);
+     check (batches [2].bufferBarriers [0].dstStageMask == VK_PIPELINE_STAGE_2_HOST_BIT && batches [2].bufferBarriers [0].dstAccessMask == VK_ACCESS_2_HOST_READ_BIT);
+     check (pointerToGraph->numberOfExecutions == 2 && pointerToGraph->barriersInTotal == 6 && pointerToGraph->batchesInTotal == 5);
+     leaveGraph (pointerToGraph);
+}
+
+void testTransients (void)
+{
+     struct transientImage transients [4] =
+          {{.requirements = {.size = 1000, .alignment = 256}, .firstPass = 0, .lastPass = 2},
+           {.requirements = {.size = 512, .alignment = 256}, .firstPass = 1, .lastPass = 3},
+           {.requirements = {.size = 1000, .alignment = 256}, .firstPass = 3, .lastPass = 5},
+           {.requirements = {.size = 256, .alignment = 256}, .firstPass = 6, .lastPass = 6},
+          };
+     check (placeTransients (transients, 4) == 1536);
+     check (transients [0].offset == 0 && transients [2].offset == 0 && transients [3].offset == 0);
+     check (transients [1].offset == 1024);
+     for (unsigned int i = 0; i < 4; ++i)
+          for (unsigned int j = 0; j < i; ++j) check (! isTransientConflict (& transients [i], & transients [j]));
+
+     struct graph * const pointerToGraph = getPointerToGraph (VK_NULL_HANDLE, NULL, 1, VK_FALSE);
+     pointerToGraph->cmdPipelineBarrier2 = recordBarriers;
+     struct point const size = {.x = 256, .y = 64};
+     VkImageUsageFlags const usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+     VkImage const target = (VkImage) (uintptr_t) 0x10, first = (VkImage) (uintptr_t) 0x40, second = (VkImage) (uintptr_t) 0x50;
+     struct transients * const pointerToTransients = & pointerToGraph->transients [0];
+     pointerToTransients->count = pointerToTransients->capacity = 2;
+     pointerToTransients->images = xcalloc (2, sizeof (struct transientImage));
+     pointerToTransients->images [0] = (struct transientImage) {.format = VK_FORMAT_B8G8R8A8_UNORM, .size = size, .usage = usage, .image = first, .requirements = {.size = 65536, .alignment = 256}, .offset = 0, .isBound = VK_TRUE};
+     pointerToTransients->images [1] = pointerToTransients->images [0];
+     pointerToTransients->images [1].image = second;
+
+     numberOfBatches = numberOfRecordings = 0;
+     resetGraph (pointerToGraph, 0);
+     unsigned int const resource = importImage (pointerToGraph, target, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+     exportResource (pointerToGraph, resource, GRAPH_PRESENT);
+     for (unsigned int i = 0; i < 2; ++i)
+     {
+          unsigned int const hud = addTransientImage (pointerToGraph, VK_FORMAT_B8G8R8A8_UNORM, size, usage);
+          useResource (pointerToGraph, addGraphPass (pointerToGraph, "overlay", recordPass, "overlay", VK_FALSE), hud, GRAPH_TRANSFER_DESTINATION);
+          unsigned int const composition = addGraphPass (pointerToGraph, "compose", recordPass, "compose", VK_FALSE);
+          useResource (pointerToGraph, composition, hud, GRAPH_TRANSFER_SOURCE);
+          useResource (pointerToGraph, composition, resource, GRAPH_TRANSFER_DESTINATION);
+     }
+     executeGraph (pointerToGraph, VK_NULL_HANDLE);
+     check (numberOfRecordings == 4 && pointerToGraph->numberOfPlacements == 0);
+     check (pointerToTransients->images [0].firstPass == 0 && pointerToTransients->images [0].lastPass == 1);
+     check (pointerToTransients->images [1].firstPass == 2 && pointerToTransients->images [1].lastPass == 3);
+     check (batches [0].numberOfImageBarriers == 1 && batches [0].imageBarriers [0].image == first);
+     check (batches [2].numberOfImageBarriers == 1 && batches [2].imageBarriers [0].image == second && batches [2].numberOfRecordingsBefore == 2);
+     check (batches [2].imageBarriers [0].oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && batches [2].imageBarriers [0].newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+     check (batches [2].imageBarriers [0].srcStageMask & VK_PIPELINE_STAGE_2_TRANSFER_BIT && batches [2].imageBarriers [0].srcAccessMask & VK_ACCESS_2_TRANSFER_WRITE_BIT);
+     pointerToTransients->count = 0;
+     free (pointerToTransients->images);
+     pointerToTransients->images = NULL;
+     leaveGraph (pointerToGraph);
+}
+
+void testRetirement (void)
+{
+     VkFence inFlight [3] = {VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE};
+     uint64_t submitted [3] = {0}, completed [3] = {0};
+     struct frames temporaryStructure = {.count = 3, .inFlight = inFlight, .submitted = submitted, .completed = completed, .numberOfSubmits = 0};
+     struct frames * const pointerToFrames = xmalloc0 (sizeof (struct frames));
+     memcpy (pointerToFrames, & temporaryStructure, sizeof (temporaryStructure));
+     struct synchronization synchronization = {.timeline = VK_NULL_HANDLE};
+     for (unsigned int slot = 0; slot < 2; ++slot)
+     {
+          waitForFrame (VK_NULL_HANDLE, pointerToFrames, & synchronization, slot);
+          submitted [slot] = ++ pointerToFrames->numberOfSubmits;
+     }
+     uint64_t const lastFrame = pointerToFrames->numberOfSubmits;
+     check (! isFrameCompleted (pointerToFrames, lastFrame));
+     for (unsigned int i = 0; i < 8; ++i) waitForFrame (VK_NULL_HANDLE, pointerToFrames, & synchronization, 2);
+     check (! isFrameCompleted (pointerToFrames, lastFrame));
+     for (unsigned int frame = 2; frame < 5; ++frame)
+     {
+          waitForFrame (VK_NULL_HANDLE, pointerToFrames, & synchronization, frame % 3);
+          check (! isFrameCompleted (pointerToFrames, lastFrame));
+          submitted [frame % 3] = ++ pointerToFrames->numberOfSubmits;
+     }
+     for (unsigned int frame = 5; frame < 8; ++frame)
+     {
+          waitForFrame (VK_NULL_HANDLE, pointerToFrames, & synchronization, frame % 3);
+          check (isFrameCompleted (pointerToFrames, lastFrame) == (frame == 7));
+          submitted [frame % 3] = ++ pointerToFrames->numberOfSubmits;
+     }
+     free (pointerToFrames);
+}
+
+void pushTestLog (char const * const format, ...)
+{
+     va_list arguments;
+     va_start (arguments, format);
+     pushLog (LOG_DEBUG, format, arguments);
+     va_end (arguments);
+}
+
+void * pushTestLogs (void * const argument)
+{
+     for (unsigned int i = 0; i < LOG_RING_SIZE / 4; ++i) pushTestLog ("producer %u message %u", (unsigned int) (uintptr_t) argument, i);
+     return NULL;
+}
+
+void testLogRing (void)
+{
+     startLogging ( );
+     stopLogging ( );
+     fflush (stdout);
+     int const standardOutput = dup (STDOUT_FILENO), discard = open ("/dev/null", O_WRONLY);
+     dup2 (discard, STDOUT_FILENO);
+     for (unsigned int i = 0; i < 3; ++i) pushTestLog ("message %u", i);
+     check (atomic_load (& logRing.head) == 3 && atomic_load (& logRing.slots [2].sequence) == 3 && atomic_load (& logRing.slots [3].sequence) == 3);
+     check (flushLog ( ) == 3);
+     check (logRing.tail == 3 && atomic_load (& logRing.slots [0].sequence) == LOG_RING_SIZE && atomic_load (& logRing.slots [2].sequence) == LOG_RING_SIZE + 2);
+     for (unsigned int i = 0; i < LOG_RING_SIZE; ++i) pushTestLog ("message %u", i);
+     check (atomic_load (& logRing.head) == LOG_RING_SIZE + 3 && atomic_load (& logRing.dropped) == 0);
+     pushTestLog ("dropped");
+     check (atomic_load (& logRing.head) == LOG_RING_SIZE + 3 && atomic_load (& logRing.dropped) == 1);
+     check (atomic_load (& logRing.slots [2].sequence) == LOG_RING_SIZE + 3);
+     check (flushLog ( ) == LOG_RING_SIZE);
+     check (logRing.tail == LOG_RING_SIZE + 3 && atomic_load (& logRing.dropped) == 0);
+     pthread_t producers [4];
+     for (unsigned int i = 0; i < 4; ++i) pthread_create (& producers [i], NULL, pushTestLogs, (void *) (uintptr_t) i);
+     for (unsigned int i = 0; i < 4; ++i) pthread_join (producers [i], NULL);
+     check (atomic_load (& logRing.head) == 2 * LOG_RING_SIZE + 3 && atomic_load (& logRing.dropped) == 0);
+     check (flushLog ( ) == LOG_RING_SIZE);
+     check (flushLog ( ) == 0);
+     fflush (stdout);
+     dup2 (standardOutput, STDOUT_FILENO);
+     close (discard);
+     close (standardOutput);
+}
+
+int main (void)
+{
+     testBuddy ( );
+     testArena ( );
+     testStaging ( );
+     testGraph ( );
+     testTransients ( );
+     testRetirement ( );
+     testLogRing ( );
+     printf ("%u checks, %u failed\n", numberOfChecks, numberOfFailures);
+     return numberOfFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}